@@ -35,8 +35,17 @@
 // any official policies, either expressed or implied.
 
 #include "qrclip_app.h"
+#include "qrclip_batch.h"
+#include "qrclip_monitor.h"
 
 int main(int argc, char *argv[])
 {
+    // Batch mode doesn't need (or want) a display
+    if (QrClipBatch::isBatch(argc, argv)) {
+        return QrClipBatch(argc, argv).run();
+    }
+    if (QrClipMonitor::isQuery(argc, argv)) {
+        return QrClipMonitor::query(argc, argv);
+    }
     return QrClipApp(argc, argv).exec();
 }
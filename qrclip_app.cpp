@@ -36,8 +36,14 @@
 
 #include "qrclip_app.h"
 #include "qrclip_config.h"
+#include "qrclip_debug.h"
+#include "qrclip_monitor.h"
+#include "qrclip_stream.h"
+#include "qrclip_watchdog.h"
 #include "qrclip_window.h"
 
+#include <QtCore/QCommandLineParser>
+
 //===========================================================================
 // QrClipApp::Data
 //===========================================================================
@@ -52,13 +58,14 @@ public:
     ~Data();
 
 private:
-    void createWindow(QApplication*);
+    void createWindow(QApplication*, QrClipWindow* aPrevious = nullptr);
 
 private Q_SLOTS:
     void onRestart();
 
 private:
     QrClipConfig iConfig;
+    QrClipStream* iStream;
     QrClipWindow* iWindow;
 
 };
@@ -66,8 +73,56 @@ private:
 QrClipApp::Data::Data(
     QrClipApp* aApp) :
     QObject(aApp),
+    iStream(nullptr),
     iWindow(nullptr)
 {
+    QCommandLineParser parser;
+    QCommandLineOption streamOption("stream",
+        "Show the file (or stdin) as an animated QR code.", "file|-");
+    QCommandLineOption fpsOption("fps",
+        "Frame rate for --stream, up to 60 (default: 10).", "n", "10");
+    QCommandLineOption watchdogOption("watchdog",
+        "Log event loop stalls longer than ms (default: off).", "ms");
+    QCommandLineOption monitorOption("monitor",
+        "Collect statistics for --stats (default: off).");
+    QCommandLineOption statsOption("stats",
+        "Print statistics of the running instance and exit.");
+
+    parser.setApplicationDescription("Shows clipboard text as a QR code.");
+    parser.addHelpOption();
+    parser.addOption(streamOption);
+    parser.addOption(fpsOption);
+    parser.addOption(watchdogOption);
+    parser.addOption(monitorOption);
+    parser.addOption(statsOption); // Handled by QrClipMonitor::query
+    parser.process(*aApp);
+
+    // Before anything worth measuring. Stage timers cost nothing
+    // unless someone is interested in the numbers.
+    if (parser.isSet(monitorOption) ||
+        iConfig.get(QStringLiteral("monitor")).toBool()) {
+        new QrClipMonitor(this);
+    }
+
+    // The command line overrides the config
+    const int watchdog = parser.isSet(watchdogOption) ?
+        parser.value(watchdogOption).toInt() :
+        iConfig.get(QStringLiteral("watchdog")).toInt();
+
+    if (watchdog > 0) {
+        new QrClipWatchdog(watchdog, this);
+    }
+
+    if (parser.isSet(streamOption)) {
+        iStream = new QrClipStream(parser.value(streamOption),
+            parser.value(fpsOption).toInt(), this);
+        if (!iStream->isValid()) {
+            WARN("Nothing to stream");
+            QMetaObject::invokeMethod(aApp, []() { QCoreApplication::exit(1); },
+                Qt::QueuedConnection);
+        }
+    }
+
     createWindow(aApp);
 }
 
@@ -80,20 +135,22 @@ void
 QrClipApp::Data::onRestart()
 {
     QApplication* app = qobject_cast<QApplication*>(parent());
+    QrClipWindow* previous = iWindow;
 
     // Delete the old window later because it's actually the one
-    // who emitted the signal.
-    iWindow->disconnect(app);
-    iWindow->hide();
-    iWindow->deleteLater();
-    createWindow(app);
+    // who emitted the signal. The new one takes over its widget.
+    previous->disconnect(app);
+    createWindow(app, previous);
+    previous->hide();
+    previous->deleteLater();
 }
 
 void
 QrClipApp::Data::createWindow(
-    QApplication* aApp)
+    QApplication* aApp,
+    QrClipWindow* aPrevious)
 {
-    iWindow = new QrClipWindow(iConfig);
+    iWindow = new QrClipWindow(iConfig, iStream, aPrevious);
     connect(iWindow, &QrClipWindow::restart, this, &Data::onRestart);
     connect(iWindow, &QrClipWindow::closed, aApp, &QApplication::quit);
     iWindow->show();
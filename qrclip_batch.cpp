@@ -0,0 +1,282 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_batch.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_png.h"
+#include "qrclip_symbol.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QRunnable>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <stdio.h>
+#include <string.h>
+
+//===========================================================================
+// QrClipBatch::Data
+//===========================================================================
+
+class QrClipBatch::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Data(QrClipBatch*);
+
+    bool readPayloads(const QString&, char);
+    QString fileName(int) const;
+
+public:
+    QString iInput;
+    QDir iOutput;
+    char iSeparator;
+    int iScale;
+    int iBorder;
+    int iThreads;
+    QString iError;
+    QVector<QByteArray> iPayloads;
+    QAtomicInt iNext;
+    QAtomicInt iFailed;
+};
+
+QrClipBatch::Data::Data(
+    QrClipBatch* aApp) :
+    QObject(aApp),
+    iSeparator('\n'),
+    iScale(5),
+    iBorder(2),
+    iThreads(QThread::idealThreadCount())
+{
+    QCommandLineParser parser;
+    QCommandLineOption batchOption("batch",
+        "Save QR codes for each payload in the file (or stdin).", "file|-");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+        "Output directory (default: current directory).", "dir", ".");
+    QCommandLineOption nullOption(QStringList() << "0" << "null",
+        "Payloads are separated by NUL rather than newline.");
+    QCommandLineOption scaleOption("scale",
+        "Pixels per module (default: 5).", "n", "5");
+    QCommandLineOption threadsOption("threads",
+        "Number of threads (default: number of cores).", "n");
+
+    parser.setApplicationDescription("Saves QR codes as PNG files.");
+    parser.addHelpOption();
+    parser.addOption(batchOption);
+    parser.addOption(outputOption);
+    parser.addOption(nullOption);
+    parser.addOption(scaleOption);
+    parser.addOption(threadsOption);
+    parser.process(*aApp);
+
+    iInput = parser.value(batchOption);
+    iOutput.setPath(parser.value(outputOption));
+    iScale = qMax(parser.value(scaleOption).toInt(), 1);
+    if (parser.isSet(nullOption)) {
+        iSeparator = '\0';
+    }
+    if (parser.isSet(threadsOption)) {
+        iThreads = parser.value(threadsOption).toInt();
+    }
+    iThreads = qMax(iThreads, 1);
+}
+
+bool
+QrClipBatch::Data::readPayloads(
+    const QString& aInput,
+    char aSeparator)
+{
+    QFile file;
+    bool ok;
+
+    if (aInput == QStringLiteral("-")) {
+        ok = file.open(stdin, QIODevice::ReadOnly);
+    } else {
+        file.setFileName(aInput);
+        ok = file.open(QIODevice::ReadOnly);
+    }
+
+    if (ok) {
+        const QByteArray data(file.readAll());
+        const char* ptr = data.constData();
+        const char* end = ptr + data.size();
+
+        while (ptr < end) {
+            const char* next = (const char*)memchr(ptr, aSeparator, end - ptr);
+            const char* stop = next ? next : end;
+
+            // Tolerate CRLF line endings
+            if (aSeparator == '\n' && stop > ptr && stop[-1] == '\r') {
+                stop--;
+            }
+            if (stop > ptr) {
+                iPayloads.append(QByteArray(ptr, int(stop - ptr)));
+            }
+            ptr = next ? (next + 1) : end;
+        }
+    } else {
+        iError = file.errorString();
+    }
+    return ok;
+}
+
+QString
+QrClipBatch::Data::fileName(
+    int aIndex) const
+{
+    // Zero padded so that the files are sorted in the input order
+    const int digits = QString::number(qMax(iPayloads.size() - 1, 0)).size();
+
+    return iOutput.filePath(QString("%1.png").arg(aIndex + 1, qMax(digits, 4),
+        10, QChar('0')));
+}
+
+//===========================================================================
+// QrClipBatch::Task
+//===========================================================================
+
+// Each task keeps grabbing the next payload until there are none left
+class QrClipBatch::Task :
+    public QRunnable
+{
+public:
+    Task(Data* aData) : iData(aData) { setAutoDelete(true); }
+
+    void run() override;
+
+private:
+    Data* iData;
+};
+
+void
+QrClipBatch::Task::run()
+{
+    const int n = iData->iPayloads.size();
+    int i;
+
+    while ((i = iData->iNext.fetchAndAddRelaxed(1)) < n) {
+        const QString text(QString::fromUtf8(iData->iPayloads.at(i)));
+        const QrClipSymbol code(QrClipSymbol::makeQrCode(text));
+
+        if (code.isNull()) {
+            WARN("Payload" << (i + 1) << "is too long");
+            iData->iFailed.ref();
+        } else {
+            const QString file(iData->fileName(i));
+
+            QFile f(file);
+            const QByteArray png(QrClipPng::encode(code.makeImage(
+                iData->iScale, iData->iBorder), 9));
+
+            if (!f.open(QIODevice::WriteOnly) || f.write(png) < 0) {
+                WARN("Failed to write" << qPrintable(file));
+                iData->iFailed.ref();
+            }
+        }
+    }
+}
+
+//===========================================================================
+// QrClipBatch
+//===========================================================================
+
+QrClipBatch::QrClipBatch(
+    int& aArgc,
+    char** aArgv) :
+    QCoreApplication(aArgc, aArgv),
+    d(new Data(this))
+{}
+
+// Checked before any application object is created, because QrClipApp
+// wants a display and this one doesn't.
+// static
+bool
+QrClipBatch::isBatch(
+    int aArgc,
+    char** aArgv)
+{
+    for (int i = 1; i < aArgc; i++) {
+        if (!strcmp(aArgv[i], "--batch") ||
+            !strncmp(aArgv[i], "--batch=", 8)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int
+QrClipBatch::run()
+{
+    if (!d->readPayloads(d->iInput, d->iSeparator)) {
+        WARN(qPrintable(d->iInput) << ":" << qPrintable(d->iError));
+        return 2;
+    }
+    if (!d->iOutput.exists() && !d->iOutput.mkpath(".")) {
+        WARN("Can't create" << qPrintable(d->iOutput.path()));
+        return 2;
+    }
+
+    QThreadPool pool;
+    QElapsedTimer timer;
+    const int n = d->iPayloads.size();
+    const int threads = qMin(d->iThreads, qMax(n, 1));
+
+    timer.start();
+    pool.setMaxThreadCount(threads);
+    for (int i = 0; i < threads; i++) {
+        pool.start(new Task(d));
+    }
+    pool.waitForDone();
+
+    const qint64 ns = qMax(timer.nsecsElapsed(), Q_INT64_C(1));
+    const int failed = d->iFailed.loadAcquire();
+
+    QTextStream(stdout) << (n - failed) << " symbols in " <<
+        (ns / 1000000) << " ms on " << threads << " thread(s), " <<
+        qRound64(1e9 * (n - failed) / ns) << " symbols/s\n";
+    return failed ? 1 : 0;
+}
+
+#include "qrclip_batch.moc"
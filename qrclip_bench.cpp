@@ -0,0 +1,324 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+// Encoding and rasterization microbenchmarks. Results are written as JSON
+// so that runs made with different builds (or Qt and libqrencode versions)
+// can be compared with a script.
+
+#include "qrclip_symbol.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QVector>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QPixmap>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+enum {
+    Batches = 5
+};
+
+const char* const LevelNames[] = { "L", "M", "Q", "H" };
+
+class Bench
+{
+public:
+    Bench(const QString&, int);
+
+    bool enabled(const QString&) const;
+    void run(const QString&, QJsonObject, const std::function<void()>&);
+    QJsonArray results() const { return iResults; }
+
+private:
+    const QString iFilter;
+    const qint64 iMinBatchNs;
+    QJsonArray iResults;
+};
+
+Bench::Bench(
+    const QString& aFilter,
+    int aMinBatchMs) :
+    iFilter(aFilter),
+    iMinBatchNs(qint64(aMinBatchMs) * 1000000)
+{}
+
+bool
+Bench::enabled(
+    const QString& aName) const
+{
+    return iFilter.isEmpty() || aName.contains(iFilter);
+}
+
+// Calibrates the number of iterations so that a batch takes at least
+// iMinBatchNs, then runs a few batches and reports the best and the
+// median time per iteration.
+void
+Bench::run(
+    const QString& aName,
+    QJsonObject aResult,
+    const std::function<void()>& aFunction)
+{
+    QElapsedTimer timer;
+    qint64 iterations = 1;
+    qint64 ns;
+
+    aFunction(); // Warm-up
+    for (;;) {
+        timer.start();
+        for (qint64 i = 0; i < iterations; i++) {
+            aFunction();
+        }
+        ns = timer.nsecsElapsed();
+        if (ns >= iMinBatchNs || iterations >= (Q_INT64_C(1) << 30)) {
+            break;
+        }
+        iterations *= (ns > 0) ? qBound(Q_INT64_C(2),
+            2 * iMinBatchNs / ns, Q_INT64_C(100)) : 100;
+    }
+
+    QVector<double> perOp;
+    perOp.append(double(ns) / iterations);
+    while (perOp.size() < Batches) {
+        timer.start();
+        for (qint64 i = 0; i < iterations; i++) {
+            aFunction();
+        }
+        perOp.append(double(timer.nsecsElapsed()) / iterations);
+    }
+    std::sort(perOp.begin(), perOp.end());
+
+    aResult.insert("name", aName);
+    aResult.insert("iterations", double(iterations));
+    aResult.insert("min_ns", qRound64(perOp.first()));
+    aResult.insert("median_ns", qRound64(perOp.at(Batches / 2)));
+    iResults.append(aResult);
+
+    fprintf(stderr, "%-12s %10lld ns  %s\n", qPrintable(aName),
+        qRound64(perOp.at(Batches / 2)), QJsonDocument(aResult).
+        toJson(QJsonDocument::Compact).constData());
+}
+
+// Deterministic payloads of various kinds
+QString
+makePayload(
+    const QString& aKind,
+    int aLength)
+{
+    static const char alnum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+    static const char text[] = "The quick brown fox jumps over the lazy dog. "
+        "https://example.com/?q=42 ";
+    static const ushort kana[] = { 0x65e5, 0x672c, 0x8a9e, 0x306e, 0x30c6,
+        0x30ad, 0x30b9, 0x30c8, 0x3002 };
+    QString s;
+
+    s.reserve(aLength);
+    for (int i = 0; i < aLength; i++) {
+        if (aKind == QStringLiteral("numeric")) {
+            s.append(QChar('0' + (i * 7 + 3) % 10));
+        } else if (aKind == QStringLiteral("alnum")) {
+            s.append(QChar(alnum[(i * 7 + 3) % (sizeof(alnum) - 1)]));
+        } else if (aKind == QStringLiteral("kanji")) {
+            s.append(QChar(kana[i % (sizeof(kana)/sizeof(kana[0]))]));
+        } else {
+            s.append(QChar(text[i % (sizeof(text) - 1)]));
+        }
+    }
+    return s;
+}
+
+void
+benchEncode(
+    Bench* aBench)
+{
+    const QString name("encode");
+    static const char* const kinds[] = { "numeric", "alnum", "text", "kanji" };
+    static const int lengths[] = { 16, 64, 256, 1024 };
+
+    if (!aBench->enabled(name)) {
+        return;
+    }
+
+    for (uint k = 0; k < sizeof(kinds)/sizeof(kinds[0]); k++) {
+        for (uint n = 0; n < sizeof(lengths)/sizeof(lengths[0]); n++) {
+            const QString payload(makePayload(kinds[k], lengths[n]));
+
+            for (int level = QR_ECLEVEL_L; level <= QR_ECLEVEL_H; level++) {
+                // Optimal segmentation vs libqrencode's own
+                for (int optimal = 1; optimal >= 0; optimal--) {
+                    const QrClipSymbol::Params params(0, QRecLevel(level),
+                        optimal ? QR_MODE_NUL : QR_MODE_8);
+                    const QrClipSymbol code(QrClipSymbol::makeQrCode(payload,
+                        params));
+                    QJsonObject result;
+
+                    if (code.isNull()) {
+                        continue;
+                    }
+                    result.insert("payload", kinds[k]);
+                    result.insert("length", lengths[n]);
+                    result.insert("level", LevelNames[level]);
+                    result.insert("segmentation", optimal ? "optimal" :
+                        "libqrencode");
+                    result.insert("version", code.version());
+                    aBench->run(name, result, [&payload, &params]() {
+                        QrClipSymbol::makeQrCode(payload, params); });
+                }
+            }
+        }
+    }
+}
+
+void
+benchVersion(
+    Bench* aBench)
+{
+    const QString name("version");
+    const QString payload(makePayload("text", 16));
+    static const int versions[] = { 1, 5, 10, 20, 30, 40 };
+
+    if (!aBench->enabled(name)) {
+        return;
+    }
+
+    // Same payload in larger symbols, that's mostly about masking
+    for (uint i = 0; i < sizeof(versions)/sizeof(versions[0]); i++) {
+        const QrClipSymbol::Params params(versions[i], QR_ECLEVEL_M);
+        QJsonObject result;
+
+        result.insert("version", versions[i]);
+        result.insert("level", LevelNames[QR_ECLEVEL_M]);
+        aBench->run(name, result, [&payload, &params]() {
+            QrClipSymbol::makeQrCode(payload, params); });
+    }
+}
+
+void
+benchRaster(
+    Bench* aBench)
+{
+    const QString raster("raster");
+    const QString pixmap("pixmap");
+    static const int versions[] = { 2, 10, 40 };
+
+    for (uint i = 0; i < sizeof(versions)/sizeof(versions[0]); i++) {
+        const QrClipSymbol code(QrClipSymbol::makeQrCode(makePayload("text",
+            16), QrClipSymbol::Params(versions[i], QR_ECLEVEL_M)));
+
+        for (int scale = 1; scale <= 40; scale++) {
+            const int border = 2;
+            QJsonObject result;
+
+            result.insert("version", code.version());
+            result.insert("scale", scale);
+            result.insert("pixels", (code.width() + 2 * border) * scale);
+            if (aBench->enabled(raster)) {
+                aBench->run(raster, result, [&code, scale]() {
+                    code.makeImage(scale, border); });
+            }
+
+            // Conversion is measured at a few scales only, it's linear
+            // in the number of pixels anyway
+            if (aBench->enabled(pixmap) && (scale == 1 || scale % 10 == 0)) {
+                const QImage image(code.makeImage(scale, border));
+
+                aBench->run(pixmap, result, [&image]() {
+                    QPixmap::fromImage(image); });
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // QPixmap needs a QGuiApplication, which doesn't need a display
+    // with the offscreen platform
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+    QCommandLineParser parser;
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+        "Write JSON to the file rather than stdout.", "file");
+    QCommandLineOption filterOption(QStringList() << "f" << "filter",
+        "Only run benchmarks whose name contains the string.", "name");
+    QCommandLineOption timeOption(QStringList() << "t" << "time",
+        "Minimum duration of a batch (default: 20).", "ms", "20");
+
+    parser.setApplicationDescription("QR Clip microbenchmarks.");
+    parser.addHelpOption();
+    parser.addOption(outputOption);
+    parser.addOption(filterOption);
+    parser.addOption(timeOption);
+    parser.process(app);
+
+    Bench bench(parser.value(filterOption),
+        qMax(parser.value(timeOption).toInt(), 1));
+
+    benchEncode(&bench);
+    benchVersion(&bench);
+    benchRaster(&bench);
+
+    QJsonObject root;
+    root.insert("qt", QString::fromLatin1(qVersion()));
+    root.insert("libqrencode", QString::fromLatin1(QRcode_APIVersionString()));
+    root.insert("results", bench.results());
+
+    const QByteArray json(QJsonDocument(root).toJson());
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) < 0) {
+            fprintf(stderr, "%s: %s\n", qPrintable(file.fileName()),
+                qPrintable(file.errorString()));
+            return 1;
+        }
+    } else {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_cache.h"
+
+#include "qrclip_debug.h"
+
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+
+//===========================================================================
+// QrClipCache::Key
+//===========================================================================
+
+QrClipCache::Key::Key(
+    const QByteArray& aPayload,
+    const QrClipSymbol::Params& aParams) :
+    iPayload(aPayload),
+    iParams(aParams),
+    iHash(qHash(aPayload) ^
+        (uint(aParams.iVersion) << 8) ^
+        (uint(aParams.iLevel) << 4) ^
+        (uint(aParams.iMicro) << 3) ^
+        uint(aParams.iMode))
+{}
+
+bool
+QrClipCache::Key::operator==(
+    const Key& aKey) const
+{
+    // Compare the hashes first, it's cheaper. Payloads are compared too,
+    // a hash collision must never result in a wrong QR code.
+    return iHash == aKey.iHash && iParams == aKey.iParams &&
+        iPayload == aKey.iPayload;
+}
+
+int
+QrClipCache::Key::byteCount() const
+{
+    return sizeof(Key) + iPayload.size();
+}
+
+//===========================================================================
+// QrClipCache::Data
+//===========================================================================
+
+class QrClipCache::Data
+{
+public:
+    Data(int);
+
+public:
+    QMutex iMutex;
+    QCache<Key,QrClipSymbol> iCache;
+    int iHits;
+    int iMisses;
+};
+
+QrClipCache::Data::Data(
+    int aMaxBytes) :
+    iCache(aMaxBytes),
+    iHits(0),
+    iMisses(0)
+{}
+
+//===========================================================================
+// QrClipCache
+//===========================================================================
+
+QrClipCache::QrClipCache(
+    int aMaxBytes) :
+    d(new Data(aMaxBytes))
+{}
+
+QrClipCache::~QrClipCache()
+{
+    delete d;
+}
+
+QrClipSymbol
+QrClipCache::find(
+    const Key& aKey)
+{
+    QMutexLocker lock(&d->iMutex);
+    const QrClipSymbol* code = d->iCache.object(aKey);
+
+    if (code) {
+        d->iHits++;
+        DBG("Cache hit" << d->iHits << "/" << d->iMisses << "," <<
+            d->iCache.count() << "symbol(s)," << d->iCache.totalCost() <<
+            "bytes");
+        return *code;
+    } else {
+        d->iMisses++;
+        DBG("Cache miss" << d->iHits << "/" << d->iMisses);
+        return QrClipSymbol();
+    }
+}
+
+void
+QrClipCache::insert(
+    const Key& aKey,
+    const QrClipSymbol& aCode)
+{
+    QMutexLocker lock(&d->iMutex);
+
+    // QCache takes ownership of the object (and deletes it right away
+    // if it's larger than the whole cache)
+    d->iCache.insert(aKey, new QrClipSymbol(aCode),
+        aKey.byteCount() + aCode.byteCount());
+}
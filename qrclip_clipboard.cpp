@@ -0,0 +1,520 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_clipboard.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_stats.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QProcess>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
+#include <QtGui/QGuiApplication>
+
+namespace {
+
+QrClipStandInClipboard* gStandIn = nullptr;
+
+} // namespace
+
+//===========================================================================
+// QrClipClipboard::Data
+//===========================================================================
+
+class QrClipClipboard::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Source {
+        Selection,
+        Clipboard,
+        SourceCount
+    };
+
+    // Selection changes while the mouse is being dragged, only the last
+    // one matters. An external reader gets FetchTimeoutMs to deliver the
+    // text, after that it's killed and the text stays what it was. That,
+    // or anything that takes longer than SlowFetchMs to fetch directly,
+    // is not fetched again for at least MinBackoffMs, and that interval
+    // doubles every time the owner is slow again.
+    enum {
+        SelectionDelayMs = 100,
+        SlowFetchMs = 200,
+        FetchTimeoutMs = 1000,
+        MinBackoffMs = 1000,
+        MaxBackoffMs = 30000
+    };
+
+    Data(QrClipClipboard*);
+
+    static QClipboard::Mode mode(Source);
+    static QStringList readCommand(Source);
+    void changed(Source);
+    void schedule(int);
+    void backOff(Source, qint64);
+    bool isReading() const;
+    void read(Source);
+    void update();
+
+public Q_SLOTS:
+    void onDataChanged();
+    void onSelectionChanged();
+    void onReadFinished();
+    void onReadTimeout();
+    void fetch();
+
+public:
+    QrClipStandInClipboard* iStandIn;
+    QClipboard* iClipboard;
+    QTimer* iFetchTimer;
+    bool iPaused;
+    bool iFetched;
+    QString iCurrentText;
+    uint iCurrentHash;
+    QString iText[SourceCount];
+    uint iHash[SourceCount];
+    bool iPending[SourceCount];
+    int iBackoff[SourceCount];
+    QElapsedTimer iSince[SourceCount];
+    QStringList iCommand[SourceCount];
+    QProcess* iReader[SourceCount];
+    QTimer* iDeadline[SourceCount];
+};
+
+QrClipClipboard::Data::Data(
+    QrClipClipboard* aParent) :
+    QObject(aParent),
+    iStandIn(gStandIn),
+    iClipboard(QGuiApplication::clipboard()),
+    iFetchTimer(new QTimer(this)),
+    iPaused(false),
+    iFetched(false),
+    iCurrentHash(uint(qHash(iCurrentText)))
+{
+    iFetchTimer->setSingleShot(true);
+    connect(iFetchTimer, &QTimer::timeout, this, &Data::fetch);
+    for (int i = 0; i < SourceCount; i++) {
+        iPending[i] = true;
+        iHash[i] = iCurrentHash;
+        iBackoff[i] = 0;
+        if (!iStandIn) {
+            iCommand[i] = readCommand(Source(i));
+        }
+        iReader[i] = nullptr;
+        iDeadline[i] = new QTimer(this);
+        iDeadline[i]->setSingleShot(true);
+        iDeadline[i]->setInterval(FetchTimeoutMs);
+        connect(iDeadline[i], &QTimer::timeout, this, &Data::onReadTimeout);
+    }
+    if (iStandIn) {
+        connect(iStandIn, &QrClipStandInClipboard::dataChanged,
+            this, &Data::onDataChanged);
+        connect(iStandIn, &QrClipStandInClipboard::selectionChanged,
+            this, &Data::onSelectionChanged);
+        schedule(0);
+    } else if (iClipboard) {
+        if (!iClipboard->supportsSelection()) {
+            iPending[Selection] = false;
+        }
+        connect(iClipboard, &QClipboard::dataChanged,
+            this, &Data::onDataChanged);
+        connect(iClipboard, &QClipboard::selectionChanged,
+            this, &Data::onSelectionChanged);
+
+        // The initial fetch doesn't have to happen right away either
+        schedule(0);
+    }
+}
+
+// static
+QClipboard::Mode
+QrClipClipboard::Data::mode(
+    Source aSource)
+{
+    return (aSource == Selection) ? QClipboard::Selection :
+        QClipboard::Clipboard;
+}
+
+// QClipboard can only be used on the GUI thread, and it blocks until
+// the owner responds or Qt gives up on it, which takes seconds. Where
+// there's a tool which can read the clipboard, it's run instead, and
+// the GUI thread doesn't wait for it. Empty list if there's none.
+// static
+QStringList
+QrClipClipboard::Data::readCommand(
+    Source aSource)
+{
+    const QString platform(QGuiApplication::platformName());
+    const bool primary = (aSource == Selection);
+    QString exe;
+
+    if (platform == QStringLiteral("xcb")) {
+        exe = QStandardPaths::findExecutable("xclip");
+        if (!exe.isEmpty()) {
+            return QStringList() << exe << "-o" << "-selection" <<
+                (primary ? "primary" : "clipboard");
+        }
+        exe = QStandardPaths::findExecutable("xsel");
+        if (!exe.isEmpty()) {
+            return QStringList() << exe << "-o" << (primary ? "-p" : "-b");
+        }
+    } else if (platform.startsWith(QStringLiteral("wayland"))) {
+        exe = QStandardPaths::findExecutable("wl-paste");
+        if (!exe.isEmpty()) {
+            QStringList command;
+
+            command << exe << "--no-newline" << "--type" << "text";
+            if (primary) {
+                command << "--primary";
+            }
+            return command;
+        }
+    }
+    return QStringList();
+}
+
+void
+QrClipClipboard::Data::onDataChanged()
+{
+    changed(Clipboard);
+}
+
+void
+QrClipClipboard::Data::onSelectionChanged()
+{
+    changed(Selection);
+}
+
+void
+QrClipClipboard::Data::changed(
+    Source aSource)
+{
+    iPending[aSource] = true;
+    if (!iPaused) {
+        if (aSource == Selection) {
+            // Restarting the timer keeps postponing the fetch until
+            // the selection settles down
+            schedule(SelectionDelayMs);
+        } else {
+            schedule(0);
+        }
+    }
+}
+
+void
+QrClipClipboard::Data::schedule(
+    int aDelay)
+{
+    iFetchTimer->start(aDelay);
+}
+
+void
+QrClipClipboard::Data::backOff(
+    Source aSource,
+    qint64 aMs)
+{
+    iBackoff[aSource] = qBound(int(MinBackoffMs), 2 * iBackoff[aSource],
+        int(MaxBackoffMs));
+    iSince[aSource].start();
+    WARN("Clipboard" << aSource << "took" << aMs << "ms,"
+        "backing off for" << iBackoff[aSource] << "ms");
+}
+
+bool
+QrClipClipboard::Data::isReading() const
+{
+    for (int i = 0; i < SourceCount; i++) {
+        if (iReader[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Starts the external reader, the result arrives asynchronously
+void
+QrClipClipboard::Data::read(
+    Source aSource)
+{
+    const QStringList& command = iCommand[aSource];
+    QProcess* reader = new QProcess(this);
+
+    QrClipStats::count(QrClipStats::ClipboardFetches);
+    iReader[aSource] = reader;
+    iSince[aSource].start();
+    reader->setProperty("source", int(aSource));
+    reader->setProcessChannelMode(QProcess::SeparateChannels);
+    reader->setStandardInputFile(QProcess::nullDevice());
+    reader->setStandardErrorFile(QProcess::nullDevice());
+    connect(reader, QOverload<int, QProcess::ExitStatus>::of(
+        &QProcess::finished), this, &Data::onReadFinished);
+    connect(reader, &QProcess::errorOccurred, this, &Data::onReadFinished);
+    iDeadline[aSource]->start();
+    reader->start(command.first(), command.mid(1), QIODevice::ReadOnly);
+}
+
+void
+QrClipClipboard::Data::onReadFinished()
+{
+    QProcess* reader = qobject_cast<QProcess*>(sender());
+    const Source source = Source(reader->property("source").toInt());
+
+    // finished() may follow errorOccurred()
+    if (iReader[source] == reader) {
+        const qint64 ms = iSince[source].elapsed();
+
+        iReader[source] = nullptr;
+        iDeadline[source]->stop();
+        reader->disconnect(this);
+        reader->deleteLater();
+
+        // Nothing to paste is a non-zero exit, and that's an empty text
+        if (reader->error() == QProcess::FailedToStart) {
+            WARN("Failed to run" << qPrintable(iCommand[source].first()));
+            iCommand[source].clear();
+            iPending[source] = true;
+        } else if (reader->exitStatus() == QProcess::NormalExit &&
+            !reader->exitCode()) {
+            iText[source] = QString::fromUtf8(reader->readAllStandardOutput());
+        } else {
+            iText[source].clear();
+        }
+        iHash[source] = uint(qHash(iText[source]));
+        if (ms > SlowFetchMs) {
+            backOff(source, ms);
+        } else {
+            iBackoff[source] = 0;
+        }
+
+        // Changes which came in while the reader was running get
+        // fetched now, those which come while paused on resume
+        if (iPaused) {
+            iPending[source] = true;
+        } else if (iFetchTimer->isActive()) {
+            // fetch() is coming anyway
+        } else if (iPending[Selection] || iPending[Clipboard]) {
+            schedule(0);
+        } else if (!isReading()) {
+            update();
+        }
+    }
+}
+
+void
+QrClipClipboard::Data::onReadTimeout()
+{
+    for (int i = 0; i < SourceCount; i++) {
+        QProcess* reader = iReader[i];
+
+        if (reader && !iDeadline[i]->isActive()) {
+            const Source source = Source(i);
+
+            // The owner isn't responding, the last known text stays
+            iReader[i] = nullptr;
+            reader->disconnect(this);
+            if (reader->state() == QProcess::NotRunning) {
+                reader->deleteLater();
+            } else {
+                connect(reader, QOverload<int, QProcess::ExitStatus>::of(
+                    &QProcess::finished), reader, &QObject::deleteLater);
+                reader->kill();
+            }
+            backOff(source, iSince[i].elapsed());
+            if (!iPaused) {
+                update();
+            }
+        }
+    }
+}
+
+void
+QrClipClipboard::Data::fetch()
+{
+    int retry = -1;
+
+    for (int i = 0; i < SourceCount && !iPaused; i++) {
+        if (iPending[i] && !iReader[i]) {
+            const Source source = Source(i);
+
+            if (iBackoff[i] && !iSince[i].hasExpired(iBackoff[i])) {
+                // Still leaving this one alone
+                const int left = int(iBackoff[i] - iSince[i].elapsed());
+
+                retry = (retry < 0) ? left : qMin(retry, left);
+            } else if (!iCommand[i].isEmpty() && !((source == Selection) ?
+                iClipboard->ownsSelection() : iClipboard->ownsClipboard())) {
+                iPending[i] = false;
+                read(source);
+            } else {
+                // No reader, or it's our own data which can be fetched
+                // without a round trip
+                QElapsedTimer timer;
+
+                timer.start();
+                iPending[i] = false;
+                {
+                    QRCLIP_TIME(QrClipStageClipboard);
+                    QrClipStats::count(QrClipStats::ClipboardFetches);
+                    iText[i] = iStandIn ? iStandIn->text(mode(source)) :
+                        iClipboard->text(mode(source));
+                }
+                iHash[i] = uint(qHash(iText[i]));
+
+                const qint64 ms = timer.elapsed();
+
+                if (ms > SlowFetchMs) {
+                    backOff(source, ms);
+                } else {
+                    iBackoff[i] = 0;
+                }
+            }
+        }
+    }
+
+    if (retry >= 0) {
+        schedule(retry);
+    }
+
+    // Wait for all readers, one source at a time would flash the other
+    // one's text on the screen
+    if (!iPaused && !isReading()) {
+        update();
+    }
+}
+
+void
+QrClipClipboard::Data::update()
+{
+    // Non-empty selection takes precedence. The hash is calculated once
+    // per fetch, and a different length or hash is enough to tell that
+    // the text has changed. Matching ones don't prove that it hasn't,
+    // the text still has to be compared to rule out a collision.
+    const Source source = iText[Selection].isEmpty() ? Clipboard : Selection;
+    const QString& text = iText[source];
+
+    if (!iFetched || iCurrentText.size() != text.size() ||
+        iCurrentHash != iHash[source] || iCurrentText != text) {
+        iFetched = true;
+        iCurrentText = text;
+        iCurrentHash = iHash[source];
+        Q_EMIT qobject_cast<QrClipClipboard*>(parent())->textChanged(text);
+    }
+}
+
+//===========================================================================
+// QrClipStandInClipboard
+//===========================================================================
+
+QrClipStandInClipboard::QrClipStandInClipboard(
+    QObject* aParent) :
+    QObject(aParent)
+{
+    gStandIn = this;
+}
+
+QrClipStandInClipboard::~QrClipStandInClipboard()
+{
+    if (gStandIn == this) {
+        gStandIn = nullptr;
+    }
+}
+
+// static
+QrClipStandInClipboard*
+QrClipStandInClipboard::instance()
+{
+    return gStandIn;
+}
+
+QString
+QrClipStandInClipboard::text(
+    QClipboard::Mode aMode) const
+{
+    return (aMode == QClipboard::Selection) ? iSelection : iClipboard;
+}
+
+void
+QrClipStandInClipboard::setText(
+    const QString& aText,
+    QClipboard::Mode aMode)
+{
+    // Notifications go out even if nothing has changed, like QClipboard
+    if (aMode == QClipboard::Selection) {
+        iSelection = aText;
+        Q_EMIT selectionChanged();
+    } else {
+        iClipboard = aText;
+        Q_EMIT dataChanged();
+    }
+}
+
+//===========================================================================
+// QrClipClipboard
+//===========================================================================
+
+QrClipClipboard::QrClipClipboard(
+    QObject* aParent) :
+    QObject(aParent),
+    d(new Data(this))
+{}
+
+QString
+QrClipClipboard::text() const
+{
+    return d->iCurrentText;
+}
+
+// Changes are remembered while paused, and fetched on resume
+void
+QrClipClipboard::setPaused(
+    bool aPaused)
+{
+    if (d->iPaused != aPaused) {
+        d->iPaused = aPaused;
+        if (aPaused) {
+            d->iFetchTimer->stop();
+        } else if (d->iPending[Data::Selection] ||
+            d->iPending[Data::Clipboard]) {
+            d->schedule(0);
+        }
+    }
+}
+
+#include "qrclip_clipboard.moc"
@@ -0,0 +1,97 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_CLIPBOARD_H
+#define QRCLIP_CLIPBOARD_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtGui/QClipboard>
+
+// Follows the clipboard (or the X11 selection, if it's not empty) text.
+// Fetching it may require a round trip to another app, which may be busy
+// or not responding at all. QClipboard can only do that synchronously,
+// so the text is read by xclip, xsel or wl-paste (if there is one) with
+// a deadline. Changes are coalesced, only the source which has changed
+// is fetched, and the one whose owner turns out to be slow is left alone
+// for a while. The first fetch always emits textChanged, even if there's
+// no text.
+class QrClipClipboard :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    QrClipClipboard(QObject*);
+
+    QString text() const;
+    void setPaused(bool);
+
+Q_SIGNALS:
+    void textChanged(const QString&);
+
+private:
+    class Data;
+    Data* d;
+};
+
+// Scripted clipboard and selection, for the latency harness. While it
+// exists, QrClipClipboard objects created after it follow this one
+// instead of QClipboard. Works on any platform, offscreen included.
+class QrClipStandInClipboard :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    QrClipStandInClipboard(QObject* aParent = nullptr);
+    ~QrClipStandInClipboard();
+
+    static QrClipStandInClipboard* instance();
+
+    QString text(QClipboard::Mode) const;
+    void setText(const QString&, QClipboard::Mode aMode = QClipboard::Clipboard);
+
+Q_SIGNALS:
+    void dataChanged();
+    void selectionChanged();
+
+private:
+    QString iClipboard;
+    QString iSelection;
+};
+
+#endif // QRCLIP_CLIPBOARD_H
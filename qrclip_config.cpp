@@ -37,11 +37,16 @@
 #include "qrclip_config.h"
 
 #include "qrclip_debug.h"
+#include "qrclip_stats.h"
 
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QJsonDocument>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
 #include <QtCore/QStandardPaths>
+#include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
 
 //===========================================================================
@@ -53,11 +58,14 @@ class QrClipConfig::Data : public QObject
     Q_OBJECT
 
 public:
+    class WriteTask;
+
     Data(QString);
     ~Data();
 
     void set(const QString&, const QVariant&);
     void scheduleSave();
+    void write();
 
 private slots:
     void saveNow();
@@ -69,6 +77,24 @@ public:
     QDir iConfigDir;
     QString iConfigFile;
     QVariantMap iConfig;
+    QThreadPool iWriter;
+    QMutex iPendingMutex;
+    QByteArray iPending;
+};
+
+//===========================================================================
+// QrClipConfig::Data::WriteTask
+//===========================================================================
+
+class QrClipConfig::Data::WriteTask :
+    public QRunnable
+{
+public:
+    WriteTask(Data* aData) : iData(aData) { setAutoDelete(true); }
+    void run() override { iData->write(); }
+
+private:
+    Data* iData;
 };
 
 QrClipConfig::Data::Data(
@@ -78,6 +104,10 @@ QrClipConfig::Data::Data(
     iConfigDir(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)),
     iConfigFile(iConfigDir.absoluteFilePath(aFileName))
 {
+    // Slow (e.g. network) file systems don't block the GUI thread.
+    // A single thread keeps the writes in order.
+    iWriter.setMaxThreadCount(1);
+
     // Don't save changes more often than twice a second.
     // But if the config keeps changing, still save once in 5 sec.
     iMinSaveDelayTimer->setInterval(500);
@@ -90,6 +120,7 @@ QrClipConfig::Data::Data(
     connect(iMaxSaveDelayTimer, &QTimer::timeout, this, &Data::saveNow);
 
     // Load the config file
+    QRCLIP_TIME(QrClipStageConfigLoad);
     QFile f(iConfigFile);
 
     if (f.exists()) {
@@ -107,6 +138,7 @@ QrClipConfig::Data::~Data()
     if (iMinSaveDelayTimer->isActive()) {
         saveNow(); // Finish pending save
     }
+    iWriter.waitForDone();
 }
 
 void
@@ -137,18 +169,46 @@ QrClipConfig::Data::scheduleSave()
 void
 QrClipConfig::Data::saveNow()
 {
+    const QByteArray json(QJsonDocument::fromVariant(iConfig).toJson());
+
     iMinSaveDelayTimer->stop();
     iMaxSaveDelayTimer->stop();
 
+    // Snapshots that the writer hasn't picked up yet are replaced,
+    // only the latest one gets written.
+    iPendingMutex.lock();
+    const bool idle = iPending.isNull();
+    iPending = json;
+    iPendingMutex.unlock();
+
+    if (idle) {
+        iWriter.start(new WriteTask(this));
+    }
+}
+
+// Runs on the writer thread
+void
+QrClipConfig::Data::write()
+{
+    iPendingMutex.lock();
+    const QByteArray json(iPending);
+    iPending = QByteArray();
+    iPendingMutex.unlock();
+
+    QRCLIP_TIME(QrClipStageConfigSave);
+    QrClipStats::count(QrClipStats::ConfigSaves);
+
     if (!iConfigDir.exists() && !iConfigDir.mkpath(".")) {
         WARN("Failed to create" << qPrintable(iConfigDir.absolutePath()));
     }
 
-    QFile f(iConfigFile);
+    // QSaveFile writes a temporary file and renames it over the old one,
+    // a crash can't leave a truncated config behind
+    QSaveFile f(iConfigFile);
 
     if (!f.open(QIODevice::WriteOnly)) {
         WARN("Failed to open" << qPrintable(iConfigFile) << f.errorString());
-    } else if (f.write(QJsonDocument::fromVariant(iConfig).toJson()) < 0) {
+    } else if (f.write(json) < 0 || !f.commit()) {
         WARN("Failed to write" << qPrintable(iConfigFile) << f.errorString());
     } else {
         DBG("Saved" << qPrintable(iConfigFile));
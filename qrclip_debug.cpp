@@ -0,0 +1,224 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_debug.h"
+#include "qrclip_stats.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+#include <chrono>
+
+#include <stdio.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const StageNames[QrClipStageCount] = {
+    "clipboard",
+    "encode",
+    "raster",
+    "pixmap",
+    "paint",
+    "config_load",
+    "config_save",
+    "file_dialog"
+};
+
+// Collects the events and writes them to the file at exit
+class Trace
+{
+public:
+    class Event
+    {
+    public:
+        QrClipStage iStage;
+        int iThread;
+        qint64 iStart;
+        qint64 iDuration;
+    };
+
+    Trace();
+    ~Trace();
+
+    void append(QrClipStage, qint64, qint64);
+
+private:
+    QMutex iMutex;
+    QVector<Event> iEvents;
+    QAtomicInt iLastThread;
+};
+
+Q_GLOBAL_STATIC(Trace, trace)
+
+Trace::Trace()
+{
+    iEvents.reserve(4096);
+}
+
+Trace::~Trace()
+{
+    const QByteArray file(qgetenv("QRCLIP_TRACE"));
+    FILE* out = fopen(file.constData(), "w");
+
+    if (out) {
+        const int pid = getpid();
+
+        // Chrome wants microseconds
+        fprintf(out, "{\"traceEvents\":[");
+        for (int i = 0; i < iEvents.size(); i++) {
+            const Event& e = iEvents.at(i);
+
+            fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"qrclip\","
+                "\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,"
+                "\"tid\":%d}", i ? "," : "", StageNames[e.iStage],
+                e.iStart / 1000.0, e.iDuration / 1000.0, pid, e.iThread);
+        }
+        fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        fclose(out);
+    } else {
+        fprintf(stderr, "Can't write %s\n", file.constData());
+    }
+}
+
+void
+Trace::append(
+    QrClipStage aStage,
+    qint64 aStart,
+    qint64 aEnd)
+{
+    // Small thread ids are easier to read than the real ones
+    static thread_local int thread = 0;
+
+    if (!thread) {
+        thread = iLastThread.fetchAndAddRelaxed(1) + 1;
+    }
+
+    const Event event = { aStage, thread, aStart, aEnd - aStart };
+
+    iMutex.lock();
+    iEvents.append(event);
+    iMutex.unlock();
+}
+
+const bool TraceEnabled = !qEnvironmentVariableIsEmpty("QRCLIP_TRACE");
+bool StatsEnabled = false;
+
+// Innermost stage of the thread which called trackThisThread()
+QAtomicInt ActiveStage(QrClipStageNone);
+thread_local bool TrackedThread = false;
+
+} // namespace
+
+//===========================================================================
+// QrClipStageTimer
+//===========================================================================
+
+bool QrClipStageTimer::gEnabled = TraceEnabled;
+
+// static
+void
+QrClipStageTimer::enableStats()
+{
+    StatsEnabled = gEnabled = true;
+}
+
+// Only one thread (normally, the GUI thread) can be tracked.
+// static
+void
+QrClipStageTimer::trackThisThread()
+{
+    TrackedThread = gEnabled = true;
+}
+
+// static
+QrClipStage
+QrClipStageTimer::activeStage()
+{
+    return QrClipStage(ActiveStage.loadAcquire());
+}
+
+// static
+const char*
+QrClipStageTimer::name(
+    QrClipStage aStage)
+{
+    return StageNames[aStage];
+}
+
+// Never zero, which is what QrClipStageTimer uses as "not started"
+// static
+qint64
+QrClipStageTimer::now()
+{
+    return qMax(Q_INT64_C(1), qint64(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(std::chrono::steady_clock::now().
+        time_since_epoch()).count()));
+}
+
+void
+QrClipStageTimer::start()
+{
+    iStart = now();
+    if (TrackedThread) {
+        iTracked = true;
+        iPrevious = QrClipStage(ActiveStage.fetchAndStoreRelease(iStage));
+    }
+}
+
+void
+QrClipStageTimer::finish()
+{
+    const qint64 end = now();
+
+    if (iTracked) {
+        ActiveStage.storeRelease(iPrevious);
+    }
+
+    if (StatsEnabled) {
+        QrClipStats::record(iStage, end - iStart);
+    }
+
+    if (TraceEnabled) {
+        Trace* t = trace();
+
+        // Null if the timer outlives the static destructors
+        if (t) {
+            t->append(iStage, iStart, end);
+        }
+    }
+}
@@ -47,4 +47,60 @@
 
 #define WARN(x) (qWarning() << x)
 
+// Pipeline stages
+enum QrClipStage {
+    QrClipStageNone = -1,
+    QrClipStageClipboard,   // Fetching the clipboard text
+    QrClipStageEncode,      // Segmentation and libqrencode
+    QrClipStageRaster,      // QrClipSymbol::makeImage
+    QrClipStagePixmap,      // QImage to QPixmap conversion
+    QrClipStagePaint,       // QrClipWidget::paintEvent
+    QrClipStageConfigLoad,
+    QrClipStageConfigSave,
+    QrClipStageFileDialog,  // Waiting for the user to pick a file
+    QrClipStageCount
+};
+
+// Measures the time spent in the enclosing scope. It's just a test of
+// a global flag unless the QRCLIP_TRACE environment variable names the
+// file where Chrome trace_event JSON is written at exit, or enableStats()
+// has been called to feed QrClipStats histograms, or trackThisThread()
+// to let other threads see activeStage(). Defining QRCLIP_NO_TIMERS
+// compiles the timers out completely.
+class QrClipStageTimer
+{
+    Q_DISABLE_COPY(QrClipStageTimer)
+
+public:
+    explicit QrClipStageTimer(QrClipStage aStage) :
+        iStage(aStage), iPrevious(QrClipStageNone), iTracked(false),
+        iStart(0) { if (gEnabled) start(); }
+    ~QrClipStageTimer() { if (iStart) finish(); }
+
+    static const char* name(QrClipStage);
+    static void enableStats();
+    static void trackThisThread();
+    static QrClipStage activeStage();
+
+private:
+    static qint64 now();
+    void start();
+    void finish();
+
+private:
+    static bool gEnabled;
+    const QrClipStage iStage;
+    QrClipStage iPrevious;
+    bool iTracked;
+    qint64 iStart;
+};
+
+#ifdef QRCLIP_NO_TIMERS
+#  define QRCLIP_TIME(stage) ((void)0)
+#else
+#  define QRCLIP_TIME_(stage,line) QrClipStageTimer qrclipTimer##line(stage)
+#  define QRCLIP_TIME__(stage,line) QRCLIP_TIME_(stage,line)
+#  define QRCLIP_TIME(stage) QRCLIP_TIME__(stage,__LINE__)
+#endif
+
 #endif // QRCLIP_DEBUG_H
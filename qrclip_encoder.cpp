@@ -0,0 +1,416 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_encoder.h"
+
+#include "qrclip_cache.h"
+#include "qrclip_debug.h"
+#include "qrclip_policy.h"
+#include "qrclip_segment.h"
+#include "qrclip_spec.h"
+#include "qrclip_stats.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThreadPool>
+
+//===========================================================================
+// QrClipEncoder::Data
+//===========================================================================
+
+class QrClipEncoder::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Data(int, QrClipEncoder*);
+    ~Data();
+
+    bool isCurrent(int) const;
+    bool policyChanged() const;
+    void start();
+    bool findDemand(const QString&, QrClipPolicy::Demand*);
+    void insertDemand(const QString&, const QrClipPolicy::Demand&);
+    QrClipSymbol makeQrCode(const QString&, const QrClipSegmenter*,
+        const QrClipSymbol::Params&);
+    void onEncoded(int, const QString&, const QrClipPolicy::Demand&,
+        const QrClipSymbol::Params&, const QList<QrClipSymbol>&,
+        const QImage&);
+
+public:
+    const int iBorder;
+    int iMaxSymbols;
+    bool iTiled;
+    QrClipPolicy iPolicy;
+    QString iRequestText;
+    QSize iRequestSize;
+    bool iRequestRaster;
+    bool iPending;
+    QrClipPolicy::Demand iDemand;
+    QrClipSymbol::Params iParams;
+    QAtomicInt iGeneration;
+    QrClipCache iCache;
+    QMutex iDemandMutex;
+    QCache<QString,QrClipPolicy::Demand> iDemandCache;
+    QThreadPool iThreadPool;
+};
+
+QrClipEncoder::Data::Data(
+    int aBorder,
+    QrClipEncoder* aEncoder) :
+    QObject(aEncoder),
+    iBorder(aBorder),
+    iMaxSymbols(1),
+    iTiled(false),
+    iPolicy(aBorder),
+    iRequestRaster(false),
+    iPending(false),
+    iCache(4 * 1024 * 1024),
+    iDemandCache(64)
+{
+    // One thread is enough, there's never more than one request that
+    // we actually care about.
+    iThreadPool.setMaxThreadCount(1);
+}
+
+QrClipEncoder::Data::~Data()
+{
+    // Tasks are referencing this object
+    iGeneration.ref();
+    iThreadPool.clear();
+    iThreadPool.waitForDone();
+}
+
+inline
+bool
+QrClipEncoder::Data::isCurrent(
+    int aGeneration) const
+{
+    return iGeneration.loadAcquire() == aGeneration;
+}
+
+// True if the latest requested size calls for a different symbol
+// than the one which has been delivered last
+bool
+QrClipEncoder::Data::policyChanged() const
+{
+    return iPolicy.isEnabled() && !iDemand.isEmpty() &&
+        iPolicy.select(iDemand, iRequestSize) != iParams;
+}
+
+// The policy needs to know how many bits the text takes, and that
+// takes segmenting the text. That's remembered per text, so that
+// switching back to a recent clipboard entry skips segmentation too.
+bool
+QrClipEncoder::Data::findDemand(
+    const QString& aText,
+    QrClipPolicy::Demand* aDemand)
+{
+    QMutexLocker lock(&iDemandMutex);
+    const QrClipPolicy::Demand* demand = iDemandCache.object(aText);
+
+    if (demand) {
+        *aDemand = *demand;
+        return true;
+    }
+    return false;
+}
+
+void
+QrClipEncoder::Data::insertDemand(
+    const QString& aText,
+    const QrClipPolicy::Demand& aDemand)
+{
+    QMutexLocker lock(&iDemandMutex);
+
+    iDemandCache.insert(aText, new QrClipPolicy::Demand(aDemand));
+}
+
+// The segmenter is optional, the text only gets segmented on a miss
+QrClipSymbol
+QrClipEncoder::Data::makeQrCode(
+    const QString& aText,
+    const QrClipSegmenter* aSegmenter,
+    const QrClipSymbol::Params& aParams)
+{
+    if (aText.isEmpty()) {
+        return QrClipSymbol();
+    } else {
+        // Users tend to switch back and forth between the same few
+        // clipboard entries, a hit allows to skip libqrencode entirely.
+        const QrClipCache::Key key(aText.toUtf8(), aParams);
+        QrClipSymbol code(iCache.find(key));
+
+        if (code.isNull()) {
+            QrClipStats::count(QrClipStats::CacheMisses);
+            if (aSegmenter) {
+                code = QrClipSymbol::makeQrCode(*aSegmenter, aParams);
+            } else {
+                code = QrClipSymbol::makeQrCode(QrClipSegmenter(aText),
+                    aParams);
+            }
+            if (!code.isNull()) {
+                iCache.insert(key, code);
+            }
+        } else {
+            QrClipStats::count(QrClipStats::CacheHits);
+        }
+        return code;
+    }
+}
+
+void
+QrClipEncoder::Data::onEncoded(
+    int aGeneration,
+    const QString& aText,
+    const QrClipPolicy::Demand& aDemand,
+    const QrClipSymbol::Params& aParams,
+    const QList<QrClipSymbol>& aCodes,
+    const QImage& aImage)
+{
+    if (isCurrent(aGeneration)) {
+        // Remember what's needed to re-evaluate the policy on resize
+        iPending = false;
+        iDemand = aDemand;
+        iParams = aParams;
+        Q_EMIT qobject_cast<QrClipEncoder*>(parent())->
+            encoded(aText, aCodes, aImage);
+
+        // The widget may have been resized while this was in progress
+        if (!iPending && policyChanged()) {
+            DBG("Size has changed, re-encoding");
+            start();
+        }
+    } else {
+        DBG("Dropping stale QR code" << aGeneration);
+    }
+}
+
+//===========================================================================
+// QrClipEncoder::Task
+//===========================================================================
+
+class QrClipEncoder::Task :
+    public QRunnable
+{
+public:
+    Task(Data*, int, const QString&, const QSize&, bool);
+
+    void run() override;
+
+private:
+    Data* iData;
+    const int iGeneration;
+    const int iMaxSymbols;
+    const bool iTiled;
+    const QrClipPolicy iPolicy;
+    const QString iText;
+    const QSize iSize;
+    const bool iRaster;
+};
+
+QrClipEncoder::Task::Task(
+    Data* aData,
+    int aGeneration,
+    const QString& aText,
+    const QSize& aSize,
+    bool aRaster) :
+    iData(aData),
+    iGeneration(aGeneration),
+    iMaxSymbols(aData->iMaxSymbols),
+    iTiled(aData->iTiled),
+    iPolicy(aData->iPolicy),
+    iText(aText),
+    iSize(aSize),
+    iRaster(aRaster)
+{
+    setAutoDelete(true);
+}
+
+void
+QrClipEncoder::Task::run()
+{
+    // The request may have become obsolete while this task was waiting
+    // in the queue, or while libqrencode was doing its thing. There's no
+    // way to interrupt libqrencode, but at least we can skip the rest.
+    if (iData->isCurrent(iGeneration)) {
+        const int border = iData->iBorder;
+        const int length = iText.size();
+        QrClipPolicy::Demand demand;
+        QrClipSymbol::Params params;
+        QList<QrClipSymbol> codes;
+
+        QrClipStats::count(QrClipStats::Encodes);
+
+        // Huge clipboard contents are rejected right away, without
+        // converting or even looking at the text
+        if (length <= QrClipSpec::maxLength()) {
+            QRCLIP_TIME(QrClipStageEncode);
+            QScopedPointer<QrClipSegmenter> segmenter;
+
+            if (iPolicy.isEnabled()) {
+                if (!iData->findDemand(iText, &demand)) {
+                    segmenter.reset(new QrClipSegmenter(iText));
+                    demand = QrClipPolicy::Demand(*segmenter);
+                    iData->insertDemand(iText, demand);
+                }
+                params = iPolicy.select(demand, iSize);
+            }
+
+            const QrClipSymbol code(iData->makeQrCode(iText,
+                segmenter.data(), params));
+
+            if (!code.isNull()) {
+                codes.append(code);
+            }
+        } else {
+            DBG(length << "characters is too much");
+        }
+
+        if (codes.isEmpty() && length > 0 && iMaxSymbols > 1 &&
+            length <= QrClipSpec::maxStructuredLength(iMaxSymbols,
+            QR_ECLEVEL_M) && iData->isCurrent(iGeneration)) {
+            // Too much text for a single symbol
+            codes = QrClipSymbol::makeStructured(iText.toUtf8(),
+                QR_ECLEVEL_M, iMaxSymbols);
+            if (iTiled && !codes.isEmpty()) {
+                codes = QList<QrClipSymbol>() <<
+                    QrClipSymbol::tile(codes, 2 * border);
+            }
+        }
+
+        if (iData->isCurrent(iGeneration)) {
+            QImage image;
+
+            if (!codes.isEmpty() && iRaster && iSize.isValid()) {
+                const QrClipSymbol& first = codes.first();
+
+                image = first.makeImage(first.fitScale(iSize, border),
+                    border);
+            }
+
+            Data* data = iData;
+            const int generation = iGeneration;
+            const QString text(iText);
+
+            // Deliver the result on the thread QrClipEncoder lives on
+            QMetaObject::invokeMethod(data, [data, generation, text, demand,
+                params, codes, image]() { data->onEncoded(generation, text,
+                demand, params, codes, image); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+// Needs the Task, hence down here
+void
+QrClipEncoder::Data::start()
+{
+    // Bumping the generation invalidates whatever is still in progress,
+    // and the tasks which haven't been started yet are simply discarded.
+    const int generation = iGeneration.fetchAndAddOrdered(1) + 1;
+
+    iPending = true;
+    iThreadPool.clear();
+    iThreadPool.start(new Task(this, generation, iRequestText, iRequestSize,
+        iRequestRaster));
+}
+
+//===========================================================================
+// QrClipEncoder
+//===========================================================================
+
+QrClipEncoder::QrClipEncoder(
+    int aBorder,
+    QObject* aParent) :
+    QObject(aParent),
+    d(new Data(aBorder, this))
+{}
+
+void
+QrClipEncoder::setStructuredAppend(
+    int aMaxSymbols,
+    bool aTiled)
+{
+    // Applies to the subsequent requests
+    d->iMaxSymbols = aMaxSymbols;
+    d->iTiled = aTiled;
+}
+
+void
+QrClipEncoder::setPolicy(
+    int aModulePixels,
+    bool aMicro)
+{
+    // Applies to the subsequent requests
+    d->iPolicy = QrClipPolicy(d->iBorder, aModulePixels, aMicro);
+}
+
+void
+QrClipEncoder::encode(
+    const QString& aText,
+    const QSize& aSize,
+    bool aRaster)
+{
+    d->iRequestText = aText;
+    d->iRequestSize = aSize;
+    d->iRequestRaster = aRaster;
+    d->start();
+}
+
+// Re-encodes the last requested text if the new size calls for a
+// different symbol. Returns false if the current one is still good.
+// While a request is in progress, the new size is only remembered,
+// the policy gets re-evaluated when the result arrives.
+bool
+QrClipEncoder::resize(
+    const QSize& aSize,
+    bool aRaster)
+{
+    d->iRequestSize = aSize;
+    d->iRequestRaster = aRaster;
+    if (!d->iPending && d->policyChanged()) {
+        d->start();
+        return true;
+    }
+    return false;
+}
+
+#include "qrclip_encoder.moc"
@@ -0,0 +1,77 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_ENCODER_H
+#define QRCLIP_ENCODER_H
+
+#include "qrclip_symbol.h"
+
+#include <QtCore/QObject>
+
+// Encodes and rasterizes QR codes on a background thread. Only the most
+// recent request matters, older ones are dropped as soon as a new one
+// comes in, and their results (if any) never get delivered.
+//
+// Text which doesn't fit into a single symbol can be split into up to
+// 16 structured append symbols, which are either delivered as a list
+// or tiled into a single grid.
+//
+// With the policy enabled, the symbol is chosen to fit the size passed
+// to encode(), which is also the size of the image (if requested).
+class QrClipEncoder :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    QrClipEncoder(int, QObject*);
+
+    void setStructuredAppend(int, bool);
+    void setPolicy(int, bool);
+    void encode(const QString&, const QSize&, bool);
+    bool resize(const QSize&, bool);
+
+Q_SIGNALS:
+    // The image (if requested) is rendered for the first symbol
+    void encoded(const QString&, const QList<QrClipSymbol>&, const QImage&);
+
+private:
+    class Task;
+    class Data;
+    Data* d;
+};
+
+#endif // QRCLIP_ENCODER_H
@@ -0,0 +1,205 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_export.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_png.h"
+
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThreadPool>
+
+//===========================================================================
+// QrClipExport::Data
+//===========================================================================
+
+class QrClipExport::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Data(QrClipExport*);
+    ~Data();
+
+public:
+    QThreadPool iThreadPool;
+    int iScale;
+    int iCompression;
+};
+
+QrClipExport::Data::Data(
+    QrClipExport* aParent) :
+    QObject(aParent),
+    iScale(5),
+    iCompression(9)
+{
+    // Saves are rare, and one at a time keeps them in order
+    iThreadPool.setMaxThreadCount(1);
+}
+
+QrClipExport::Data::~Data()
+{
+    // Don't leave files half-written
+    iThreadPool.waitForDone();
+}
+
+//===========================================================================
+// QrClipExport::Task
+//===========================================================================
+
+class QrClipExport::Task :
+    public QRunnable
+{
+public:
+    Task(QrClipExport*, const QrClipSymbol&, int, const QString&, Format,
+        int, int);
+
+    void run() override;
+
+private:
+    QByteArray makeData() const;
+
+private:
+    QrClipExport* iExport;
+    const QrClipSymbol iCode;
+    const int iBorder;
+    const QString iFile;
+    const Format iFormat;
+    const int iScale;
+    const int iCompression;
+};
+
+QrClipExport::Task::Task(
+    QrClipExport* aExport,
+    const QrClipSymbol& aCode,
+    int aBorder,
+    const QString& aFile,
+    Format aFormat,
+    int aScale,
+    int aCompression) :
+    iExport(aExport),
+    iCode(aCode),
+    iBorder(aBorder),
+    iFile(aFile),
+    iFormat(aFormat),
+    iScale(aScale),
+    iCompression(aCompression)
+{
+    setAutoDelete(true);
+}
+
+QByteArray
+QrClipExport::Task::makeData() const
+{
+    switch (iFormat) {
+    case Svg:
+        return iCode.makeSvg(iBorder);
+    case Pdf:
+        return iCode.makePdf(iBorder);
+    case Png:
+        break;
+    }
+    return QrClipPng::encode(iCode.makeImage(iScale, iBorder), iCompression);
+}
+
+void
+QrClipExport::Task::run()
+{
+    const QByteArray data(makeData());
+    QSaveFile f(iFile);
+    QString error;
+
+    if (data.isEmpty()) {
+        error = QStringLiteral("Nothing to save");
+    } else if (!f.open(QIODevice::WriteOnly) || f.write(data) < 0 ||
+        !f.commit()) {
+        error = f.errorString();
+    } else {
+        DBG("Saved" << qPrintable(iFile) << data.size() << "bytes");
+    }
+
+    // Back to the owner's thread. The owner waits for the tasks to
+    // finish before it's gone, and the calls still in the queue are
+    // dropped along with the owner.
+    QrClipExport* owner = iExport;
+    const QString file(iFile);
+
+    QMetaObject::invokeMethod(owner, [owner, file, error]() {
+        if (error.isEmpty()) {
+            Q_EMIT owner->saved(file);
+        } else {
+            Q_EMIT owner->failed(file, error);
+        }
+    }, Qt::QueuedConnection);
+}
+
+//===========================================================================
+// QrClipExport
+//===========================================================================
+
+QrClipExport::QrClipExport(
+    QObject* aParent) :
+    QObject(aParent),
+    d(new Data(this))
+{}
+
+QrClipExport::~QrClipExport()
+{}
+
+void
+QrClipExport::setPngOptions(
+    int aScale,
+    int aCompression)
+{
+    d->iScale = qMax(aScale, 1);
+    d->iCompression = qBound(-1, aCompression, 9);
+}
+
+void
+QrClipExport::save(
+    const QrClipSymbol& aCode,
+    int aBorder,
+    const QString& aFile,
+    Format aFormat)
+{
+    DBG("Saving" << qPrintable(aFile));
+    d->iThreadPool.start(new Task(this, aCode, aBorder, aFile, aFormat,
+        d->iScale, d->iCompression));
+}
+
+#include "qrclip_export.moc"
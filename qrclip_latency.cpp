@@ -0,0 +1,364 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+// Clipboard-to-pixels latency. Runs the real QrClipWindow on the offscreen
+// platform, with QrClipStandInClipboard in place of the clipboard and the
+// selection, replays a few typical sequences of clipboard changes,
+// and measures the time from the last change in a sequence to the moment
+// QrClipWidget shows the matching QR code, and to the following repaint.
+// Startup is measured too, from loading the config to the first frame
+// and to the first QR code.
+
+#include "qrclip_clipboard.h"
+#include "qrclip_config.h"
+#include "qrclip_widget.h"
+#include "qrclip_window.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+#include <QtWidgets/QApplication>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+class Harness :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Harness(QrClipStandInClipboard*, QrClipWidget*, int);
+
+    bool eventFilter(QObject*, QEvent*) override;
+    void startup(const QElapsedTimer&);
+    void replay(const QString&, const QStringList&, int,
+        QClipboard::Mode aMode = QClipboard::Clipboard);
+    QJsonArray results() const { return iResults; }
+
+private Q_SLOTS:
+    void onQrCodeChanged();
+
+private:
+    void waitUntil(qint64, const std::function<bool()>&);
+    void report(const QString&, QVector<qint64>, QVector<qint64>);
+
+private:
+    enum {
+        TimeoutMs = 5000,
+        PaintTimeoutMs = 100
+    };
+
+    QrClipWidget* iWidget;
+    QrClipStandInClipboard* iClipboard;
+    const int iRounds;
+    QElapsedTimer iTimer;
+    QTimer iTick;
+    QString iExpected;
+    qint64 iChanged;
+    qint64 iReady;
+    qint64 iPainted;
+    qint64 iFirstPaint;
+    QJsonArray iResults;
+};
+
+Harness::Harness(
+    QrClipStandInClipboard* aClipboard,
+    QrClipWidget* aWidget,
+    int aRounds) :
+    iWidget(aWidget),
+    iClipboard(aClipboard),
+    iRounds(aRounds),
+    iChanged(-1),
+    iReady(-1),
+    iPainted(-1),
+    iFirstPaint(-1)
+{
+    // Makes sure that waitUntil() wakes up every now and then
+    iTick.setInterval(5);
+    iTick.start();
+    iTimer.start();
+    iWidget->installEventFilter(this);
+    connect(iWidget, &QrClipWidget::qrCodeChanged,
+        this, &Harness::onQrCodeChanged);
+}
+
+void
+Harness::onQrCodeChanged()
+{
+    // Intermediate states don't count
+    if (iChanged >= 0 && iReady < 0 && iWidget->qrCodeText() == iExpected) {
+        iReady = iTimer.nsecsElapsed();
+    }
+}
+
+bool
+Harness::eventFilter(
+    QObject* aObject,
+    QEvent* aEvent)
+{
+    if (aEvent->type() == QEvent::Paint) {
+        const qint64 now = iTimer.nsecsElapsed();
+
+        if (iFirstPaint < 0) {
+            iFirstPaint = now;
+        }
+        if (iReady >= 0 && iPainted < 0) {
+            iPainted = now;
+        }
+    }
+    return QObject::eventFilter(aObject, aEvent);
+}
+
+void
+Harness::waitUntil(
+    qint64 aDeadline,
+    const std::function<bool()>& aDone)
+{
+    while (!aDone() && iTimer.nsecsElapsed() < aDeadline) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+}
+
+// Must be called right after showing the window, with the clipboard
+// text already in place
+void
+Harness::startup(
+    const QElapsedTimer& aStartup)
+{
+    // Harness timer started after aStartup
+    const qint64 offset = aStartup.nsecsElapsed() - iTimer.nsecsElapsed();
+    QJsonObject result;
+
+    iChanged = 0;
+    iExpected = iClipboard->text(QClipboard::Clipboard);
+    waitUntil(TimeoutMs * Q_INT64_C(1000000),
+        [this]() { return iReady >= 0 && iFirstPaint >= 0; });
+
+    result.insert("name", QStringLiteral("startup"));
+    if (iFirstPaint >= 0) {
+        result.insert("first_frame_us", (iFirstPaint + offset) / 1000);
+    }
+    if (iReady >= 0) {
+        result.insert("first_code_us", (iReady + offset) / 1000);
+    } else {
+        fprintf(stderr, "startup: timed out\n");
+    }
+    iChanged = iReady = iPainted = -1;
+    iResults.append(result);
+    fprintf(stderr, "%s\n", QJsonDocument(result).
+        toJson(QJsonDocument::Compact).constData());
+}
+
+// Each round sets the texts one after another, aInterval ms apart, and
+// waits for the last one to show up
+void
+Harness::replay(
+    const QString& aName,
+    const QStringList& aTexts,
+    int aInterval,
+    QClipboard::Mode aMode)
+{
+    QVector<qint64> ready;
+    QVector<qint64> painted;
+
+    for (int round = 0; round < iRounds; round++) {
+        // Make sure that the last text of the sequence differs from
+        // whatever is there now
+        const QString suffix(QString(" #%1").arg(round));
+
+        iChanged = iReady = iPainted = -1;
+        iExpected = aTexts.last() + suffix;
+        for (int i = 0; i < aTexts.size(); i++) {
+            const bool last = (i == aTexts.size() - 1);
+
+            if (i > 0 && aInterval > 0) {
+                waitUntil(iTimer.nsecsElapsed() + aInterval * Q_INT64_C(1000000),
+                    []() { return false; });
+            }
+            if (last) {
+                iChanged = iTimer.nsecsElapsed();
+            }
+            iClipboard->setText(aTexts.at(i) + (last ? suffix : QString()),
+                aMode);
+        }
+
+        // Wait for the QR code, then give it some time to get painted
+        waitUntil(iChanged + TimeoutMs * Q_INT64_C(1000000),
+            [this]() { return iReady >= 0; });
+        if (iReady >= 0) {
+            waitUntil(iReady + PaintTimeoutMs * Q_INT64_C(1000000),
+                [this]() { return iPainted >= 0; });
+        }
+
+        if (iReady >= 0) {
+            ready.append(iReady - iChanged);
+            if (iPainted >= 0) {
+                painted.append(iPainted - iChanged);
+            }
+        } else {
+            fprintf(stderr, "%s: timed out\n", qPrintable(aName));
+        }
+    }
+    report(aName, ready, painted);
+}
+
+void
+Harness::report(
+    const QString& aName,
+    QVector<qint64> aReady,
+    QVector<qint64> aPainted)
+{
+    QJsonObject result;
+
+    result.insert("name", aName);
+    result.insert("samples", aReady.size());
+
+    // Nearest rank percentiles, in microseconds
+    const char* const names[] = { "ready", "painted" };
+    QVector<qint64>* data[] = { &aReady, &aPainted };
+
+    for (int k = 0; k < 2; k++) {
+        QVector<qint64>& v = *data[k];
+
+        if (!v.isEmpty()) {
+            const int n = v.size();
+
+            std::sort(v.begin(), v.end());
+            result.insert(QString("%1_p50_us").arg(names[k]),
+                v.at((n - 1) * 50 / 100) / 1000);
+            result.insert(QString("%1_p99_us").arg(names[k]),
+                v.at((n - 1) * 99 / 100) / 1000);
+            result.insert(QString("%1_max_us").arg(names[k]),
+                v.last() / 1000);
+        }
+    }
+    iResults.append(result);
+    fprintf(stderr, "%s\n", QJsonDocument(result).
+        toJson(QJsonDocument::Compact).constData());
+}
+
+QStringList
+makeDrag(
+    const QString& aText,
+    int aSteps)
+{
+    // Selection growing as the mouse is being dragged over the text
+    QStringList list;
+
+    for (int i = 1; i <= aSteps; i++) {
+        list.append(aText.left(aText.size() * i / aSteps));
+    }
+    return list;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    // Keep the real config file out of this
+    QStandardPaths::setTestModeEnabled(true);
+
+    QApplication app(argc, argv);
+    QCommandLineParser parser;
+    QCommandLineOption roundsOption(QStringList() << "n" << "rounds",
+        "Number of rounds per scenario (default: 50).", "n", "50");
+
+    parser.setApplicationDescription("QR Clip end-to-end latency.");
+    parser.addHelpOption();
+    parser.addOption(roundsOption);
+    parser.process(app);
+
+    const QString url("https://example.com/some/path?query=%1&lang=en");
+    const QString text(QString("The quick brown fox jumps over the lazy "
+        "dog. ").repeated(60));
+    QrClipStandInClipboard clipboard;
+    QElapsedTimer startup;
+
+    clipboard.setText(url.arg(0));
+    startup.start();
+
+    QrClipConfig config;
+    QrClipWindow window(config);
+    QrClipWidget* widget = window.findChild<QrClipWidget*>();
+    Harness harness(&clipboard, widget,
+        qMax(parser.value(roundsOption).toInt(), 1));
+
+    window.resize(400, 400);
+    window.show();
+    harness.startup(startup);
+
+    // Let the window settle down
+    QEventLoop loop;
+    QTimer::singleShot(200, &loop, SLOT(quit()));
+    loop.exec();
+
+    harness.replay("paste", QStringList() << url.arg(1), 0);
+    harness.replay("big_paste", QStringList() << text.left(2000), 0);
+    harness.replay("huge_paste", QStringList() <<
+        text.repeated(2000), 0);
+
+    // Non-empty selection takes precedence, it has to be cleared before
+    // getting back to the clipboard
+    harness.replay("selection_drag", makeDrag(text.left(600), 20), 16,
+        QClipboard::Selection);
+    clipboard.setText(QString(), QClipboard::Selection);
+    harness.replay("rapid_toggle", QStringList() << url.arg(1) << url.arg(2)
+        << url.arg(1) << url.arg(2) << url.arg(1) << url.arg(2), 2);
+
+    QJsonObject root;
+    root.insert("qt", QString::fromLatin1(qVersion()));
+    root.insert("platform", QGuiApplication::platformName());
+    root.insert("results", harness.results());
+
+    const QByteArray json(QJsonDocument(root).toJson());
+    fwrite(json.constData(), 1, json.size(), stdout);
+    return 0;
+}
+
+#include "qrclip_latency.moc"
@@ -0,0 +1,156 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_mimedata.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_png.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QStringList>
+
+//===========================================================================
+// QrClipMimeData::Data
+//===========================================================================
+
+class QrClipMimeData::Data
+{
+public:
+    Data(const QrClipSymbol&, int, int, const QString&);
+
+public:
+    const QrClipSymbol iCode;
+    const int iBorder;
+    const int iScale;
+    const QString iText;
+    const QString iPngType;
+    const QString iSvgType;
+    const QString iImageType;
+    const QString iTextType;
+    const QStringList iFormats;
+    QHash<QString,QVariant> iCache;
+};
+
+QrClipMimeData::Data::Data(
+    const QrClipSymbol& aCode,
+    int aBorder,
+    int aScale,
+    const QString& aText) :
+    iCode(aCode),
+    iBorder(aBorder),
+    iScale(aScale),
+    iText(aText),
+    iPngType("image/png"),
+    iSvgType("image/svg+xml"),
+    iImageType("application/x-qt-image"),
+    iTextType("text/plain"),
+    iFormats(QStringList() << iPngType << iSvgType << iImageType <<
+        iTextType)
+{}
+
+//===========================================================================
+// QrClipMimeData
+//===========================================================================
+
+QrClipMimeData::QrClipMimeData(
+    const QrClipSymbol& aCode,
+    int aBorder,
+    int aScale,
+    const QString& aText) :
+    d(new Data(aCode, aBorder, aScale, aText))
+{}
+
+QrClipMimeData::~QrClipMimeData()
+{
+    delete d;
+}
+
+QStringList
+QrClipMimeData::formats() const
+{
+    return d->iFormats;
+}
+
+bool
+QrClipMimeData::hasFormat(
+    const QString& aMimeType) const
+{
+    return d->iFormats.contains(aMimeType);
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+QVariant
+QrClipMimeData::retrieveData(
+    const QString& aMimeType,
+    QVariant::Type) const
+#else
+QVariant
+QrClipMimeData::retrieveData(
+    const QString& aMimeType,
+    QMetaType) const
+#endif
+{
+    // Some clipboard managers ask for the same thing over and over
+    QHash<QString,QVariant>::const_iterator it =
+        d->iCache.constFind(aMimeType);
+
+    if (it != d->iCache.constEnd()) {
+        return it.value();
+    } else {
+        const QVariant value(render(aMimeType));
+
+        d->iCache.insert(aMimeType, value);
+        return value;
+    }
+}
+
+QVariant
+QrClipMimeData::render(
+    const QString& aMimeType) const
+{
+    DBG("Rendering" << qPrintable(aMimeType));
+    if (aMimeType == d->iPngType) {
+        return QrClipPng::encode(d->iCode.makeImage(d->iScale, d->iBorder));
+    } else if (aMimeType == d->iSvgType) {
+        return d->iCode.makeSvg(d->iBorder);
+    } else if (aMimeType == d->iImageType) {
+        return d->iCode.makeImage(d->iScale, d->iBorder);
+    } else if (aMimeType == d->iTextType) {
+        return d->iText;
+    } else {
+        return QVariant();
+    }
+}
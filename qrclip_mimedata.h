@@ -0,0 +1,75 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_MIMEDATA_H
+#define QRCLIP_MIMEDATA_H
+
+#include "qrclip_symbol.h"
+
+#include <QtCore/QMimeData>
+
+// Clipboard contents offering the QR code as PNG, SVG and QImage (for
+// other Qt applications), and the text it encodes. Nothing is rendered
+// until some application asks for a particular format.
+class QrClipMimeData :
+    public QMimeData
+{
+    Q_OBJECT
+
+public:
+    QrClipMimeData(const QrClipSymbol&, int aBorder, int aScale,
+        const QString& aText);
+    ~QrClipMimeData();
+
+    QStringList formats() const override;
+    bool hasFormat(const QString&) const override;
+
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    QVariant retrieveData(const QString&, QVariant::Type) const override;
+#else
+    QVariant retrieveData(const QString&, QMetaType) const override;
+#endif
+
+private:
+    QVariant render(const QString&) const;
+
+private:
+    class Data;
+    Data* d;
+};
+
+#endif // QRCLIP_MIMEDATA_H
@@ -0,0 +1,220 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_monitor.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_stats.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QStandardPaths>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include <stdio.h>
+#include <string.h>
+
+//===========================================================================
+// QrClipMonitor::Data
+//===========================================================================
+
+class QrClipMonitor::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Data(QrClipMonitor*);
+
+    static QString serverName();
+
+private Q_SLOTS:
+    void onProbeConnected();
+    void onProbeFailed();
+    void onNewConnection();
+
+private:
+    QLocalSocket* iProbe;
+    QLocalServer* iServer;
+};
+
+QrClipMonitor::Data::Data(
+    QrClipMonitor* aParent) :
+    QObject(aParent),
+    iProbe(new QLocalSocket(this)),
+    iServer(new QLocalServer(this))
+{
+    // Don't steal the socket from another running instance, but do
+    // clean up the one left behind by a crashed one. The probe doesn't
+    // block the startup, the answer comes from the event loop.
+    connect(iProbe, &QLocalSocket::connected,
+        this, &Data::onProbeConnected);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    connect(iProbe, &QLocalSocket::errorOccurred,
+        this, &Data::onProbeFailed);
+#else
+    connect(iProbe, QOverload<QLocalSocket::LocalSocketError>::of(
+        &QLocalSocket::error), this, &Data::onProbeFailed);
+#endif
+    iProbe->connectToServer(serverName());
+}
+
+void
+QrClipMonitor::Data::onProbeConnected()
+{
+    DBG("Statistics are served by another instance");
+    iProbe->disconnect(this);
+    iProbe->abort();
+    iProbe->deleteLater();
+    iProbe = nullptr;
+}
+
+void
+QrClipMonitor::Data::onProbeFailed()
+{
+    const QString name(serverName());
+
+    // Nobody is listening
+    iProbe->disconnect(this);
+    iProbe->deleteLater();
+    iProbe = nullptr;
+
+    QLocalServer::removeServer(name);
+    iServer->setSocketOptions(QLocalServer::UserAccessOption);
+    if (iServer->listen(name)) {
+        DBG("Serving statistics at" << qPrintable(iServer->fullServerName()));
+        connect(iServer, &QLocalServer::newConnection,
+            this, &Data::onNewConnection);
+    } else {
+        WARN("Can't listen at" << qPrintable(name) << iServer->errorString());
+    }
+}
+
+// static
+QString
+QrClipMonitor::Data::serverName()
+{
+    const QString name("qrclip-stats");
+
+#ifdef Q_OS_UNIX
+    // Keep it private to the user, rather than in /tmp
+    const QString dir(QStandardPaths::writableLocation(
+        QStandardPaths::RuntimeLocation));
+
+    if (!dir.isEmpty()) {
+        return QDir(dir).filePath(name);
+    }
+#endif
+    return name;
+}
+
+void
+QrClipMonitor::Data::onNewConnection()
+{
+    QLocalSocket* socket;
+
+    // The snapshot is the whole protocol
+    while ((socket = iServer->nextPendingConnection()) != nullptr) {
+        connect(socket, &QLocalSocket::disconnected,
+            socket, &QObject::deleteLater);
+        socket->write(QrClipStats::snapshot());
+        socket->disconnectFromServer();
+    }
+}
+
+//===========================================================================
+// QrClipMonitor
+//===========================================================================
+
+QrClipMonitor::QrClipMonitor(
+    QObject* aParent) :
+    QObject(aParent),
+    d(new Data(this))
+{
+    QrClipStageTimer::enableStats();
+}
+
+QrClipMonitor::~QrClipMonitor()
+{}
+
+// static
+bool
+QrClipMonitor::isQuery(
+    int aArgc,
+    char** aArgv)
+{
+    for (int i = 1; i < aArgc; i++) {
+        if (!strcmp(aArgv[i], "--stats")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// static
+int
+QrClipMonitor::query(
+    int& aArgc,
+    char** aArgv)
+{
+    QCoreApplication app(aArgc, aArgv);
+    QLocalSocket socket;
+    QByteArray snapshot;
+
+    socket.connectToServer(Data::serverName(), QIODevice::ReadOnly);
+    if (!socket.waitForConnected(1000)) {
+        fprintf(stderr, "qrclip doesn't seem to be running with "
+            "--monitor\n");
+        return 1;
+    }
+
+    // The server disconnects after sending the snapshot
+    while (socket.waitForReadyRead(1000)) {
+        snapshot.append(socket.readAll());
+    }
+    snapshot.append(socket.readAll());
+
+    if (snapshot.isEmpty()) {
+        fprintf(stderr, "No response from qrclip\n");
+        return 1;
+    }
+
+    fwrite(snapshot.constData(), 1, snapshot.size(), stdout);
+    return 0;
+}
+
+#include "qrclip_monitor.moc"
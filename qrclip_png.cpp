@@ -0,0 +1,177 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_png.h"
+
+#include <QtCore/QtEndian>
+
+#include <string.h>
+
+namespace {
+
+class Crc32
+{
+public:
+    Crc32();
+    quint32 compute(const char*, int) const;
+
+private:
+    quint32 iTable[256];
+};
+
+Crc32::Crc32()
+{
+    for (quint32 n = 0; n < 256; n++) {
+        quint32 c = n;
+
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+        }
+        iTable[n] = c;
+    }
+}
+
+quint32
+Crc32::compute(
+    const char* aData,
+    int aSize) const
+{
+    quint32 c = 0xffffffff;
+
+    for (int i = 0; i < aSize; i++) {
+        c = iTable[(c ^ uchar(aData[i])) & 0xff] ^ (c >> 8);
+    }
+    return c ^ 0xffffffff;
+}
+
+void
+appendUInt32(
+    QByteArray* aOut,
+    quint32 aValue)
+{
+    uchar bytes[4];
+
+    qToBigEndian(aValue, bytes);
+    aOut->append((const char*)bytes, sizeof(bytes));
+}
+
+void
+appendChunk(
+    QByteArray* aPng,
+    const char* aType,
+    const QByteArray& aData)
+{
+    static const Crc32 crc;
+
+    appendUInt32(aPng, aData.size());
+
+    // The CRC covers the type and the data
+    const int start = aPng->size();
+
+    aPng->append(aType, 4);
+    aPng->append(aData);
+    appendUInt32(aPng, crc.compute(aPng->constData() + start,
+        aPng->size() - start));
+}
+
+} // namespace
+
+//===========================================================================
+// QrClipPng
+//===========================================================================
+
+// static
+QByteArray
+QrClipPng::encode(
+    const QImage& aImage,
+    int aLevel)
+{
+    const QImage image(aImage.format() == QImage::Format_Mono ? aImage :
+        aImage.convertToFormat(QImage::Format_Mono));
+    const int width = image.width();
+    const int height = image.height();
+    const int rowBytes = (width + 7) / 8;
+    QByteArray png;
+
+    if (!image.isNull()) {
+        // In grayscale PNG, 0 is black. Bits of a QImage are indices
+        // into the color table, which is {white, black} for QR codes.
+        const bool invert = image.colorCount() >= 2 &&
+            qGray(image.color(0)) > qGray(image.color(1));
+        QByteArray header;
+        QByteArray raw;
+
+        appendUInt32(&header, width);
+        appendUInt32(&header, height);
+        header.append(char(1));    // Bit depth
+        header.append(char(0));    // Grayscale
+        header.append(char(0));    // Deflate
+        header.append(char(0));    // Adaptive filtering
+        header.append(char(0));    // No interlace
+
+        raw.reserve(height * (rowBytes + 1));
+        for (int y = 0; y < height; y++) {
+            const uchar* line = image.constScanLine(y);
+
+            // Scaled symbols repeat each row many times. The Up filter
+            // turns a repeated row into zeros, which deflate takes care
+            // of very nicely.
+            if (y > 0 && !memcmp(line, image.constScanLine(y - 1),
+                rowBytes)) {
+                raw.append(char(2));
+                raw.append(rowBytes, char(0));
+            } else {
+                raw.append(char(0));
+                if (invert) {
+                    for (int i = 0; i < rowBytes; i++) {
+                        raw.append(char(~line[i]));
+                    }
+                } else {
+                    raw.append((const char*)line, rowBytes);
+                }
+            }
+        }
+
+        png.append("\x89PNG\r\n\x1a\n", 8);
+        appendChunk(&png, "IHDR", header);
+
+        // Skip the 4-byte length prepended by qCompress, the rest is
+        // a zlib stream, exactly what IDAT wants
+        appendChunk(&png, "IDAT", qCompress(raw, aLevel).mid(4));
+        appendChunk(&png, "IEND", QByteArray());
+    }
+    return png;
+}
@@ -0,0 +1,175 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_policy.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_segment.h"
+
+namespace {
+
+// From the highest to the lowest
+const QRecLevel Levels[] = {
+    QR_ECLEVEL_H, QR_ECLEVEL_Q, QR_ECLEVEL_M, QR_ECLEVEL_L
+};
+
+} // namespace
+
+//===========================================================================
+// QrClipPolicy::Demand
+//===========================================================================
+
+QrClipPolicy::Demand::Demand()
+{
+    for (int c = 0; c < QrClipSpec::VersionClasses; c++) {
+        iBits[c] = 0;
+    }
+    for (int v = 0; v < QrClipSpec::MaxMicroVersion; v++) {
+        iMicroBits[v] = -1;
+    }
+}
+
+QrClipPolicy::Demand::Demand(
+    const QrClipSegmenter& aSegmenter)
+{
+    for (int c = 0; c < QrClipSpec::VersionClasses; c++) {
+        iBits[c] = aSegmenter.isEmpty() ? 0 :
+            aSegmenter.bitCount(QrClipSpec::firstVersion(c));
+    }
+    for (int v = 0; v < QrClipSpec::MaxMicroVersion; v++) {
+        iMicroBits[v] = aSegmenter.isEmpty() ? -1 :
+            aSegmenter.microBitCount(v + 1);
+    }
+}
+
+bool
+QrClipPolicy::Demand::isEmpty() const
+{
+    return !iBits[0];
+}
+
+// Zero if it doesn't fit at all
+int
+QrClipPolicy::Demand::minVersion(
+    QRecLevel aLevel) const
+{
+    if (!isEmpty()) {
+        for (int c = 0; c < QrClipSpec::VersionClasses; c++) {
+            const int last = QrClipSpec::lastVersion(c);
+
+            for (int v = QrClipSpec::firstVersion(c); v <= last; v++) {
+                if (QrClipSpec::dataBits(v, aLevel) >= iBits[c]) {
+                    return v;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Zero if it doesn't fit into any Micro QR symbol
+int
+QrClipPolicy::Demand::minMicroVersion(
+    QRecLevel aLevel) const
+{
+    for (int v = 1; v <= QrClipSpec::MaxMicroVersion; v++) {
+        const int bits = iMicroBits[v - 1];
+
+        if (bits >= 0 && QrClipSpec::microDataBits(v, aLevel) >= bits) {
+            return v;
+        }
+    }
+    return 0;
+}
+
+//===========================================================================
+// QrClipPolicy
+//===========================================================================
+
+bool
+QrClipPolicy::isEnabled() const
+{
+    return iModulePixels > 0;
+}
+
+QrClipSymbol::Params
+QrClipPolicy::select(
+    const Demand& aDemand,
+    const QSize& aSize) const
+{
+    if (isEnabled() && !aDemand.isEmpty() && aSize.isValid()) {
+        // Widest symbol (including the quiet zone) which still gets
+        // enough pixels per module
+        const int modules = qMin(aSize.width(), aSize.height()) /
+            iModulePixels;
+        int v;
+
+        // Micro QR, if allowed, is always smaller than a full QR code
+        if (iMicro) {
+            for (uint i = 0; i < sizeof(Levels)/sizeof(Levels[0]); i++) {
+                const QRecLevel level = Levels[i];
+
+                v = aDemand.minMicroVersion(level);
+                if (v && QrClipSpec::microWidth(v) + 2 * iBorder <= modules) {
+                    DBG("Micro QR M" << v << "level" << level);
+                    return QrClipSymbol::Params(v, level, QR_MODE_NUL, true);
+                }
+            }
+        }
+
+        for (uint i = 0; i < sizeof(Levels)/sizeof(Levels[0]); i++) {
+            const QRecLevel level = Levels[i];
+
+            v = aDemand.minVersion(level);
+            if (v && QrClipSpec::width(v) + 2 * iBorder <= modules) {
+                DBG("Version" << v << "level" << level);
+                return QrClipSymbol::Params(v, level);
+            }
+        }
+
+        // Too small a window for anything, at least make the modules
+        // as large as possible
+        v = iMicro ? aDemand.minMicroVersion(QR_ECLEVEL_L) : 0;
+        if (v) {
+            return QrClipSymbol::Params(v, QR_ECLEVEL_L, QR_MODE_NUL, true);
+        }
+        v = aDemand.minVersion(QR_ECLEVEL_L);
+        if (v) {
+            return QrClipSymbol::Params(v, QR_ECLEVEL_L);
+        }
+    }
+    return QrClipSymbol::Params();
+}
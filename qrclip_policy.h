@@ -0,0 +1,84 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_POLICY_H
+#define QRCLIP_POLICY_H
+
+#include "qrclip_spec.h"
+#include "qrclip_symbol.h"
+
+#include <QtCore/QSize>
+
+class QrClipSegmenter;
+
+// Picks the symbol type, version and error correction level for the
+// payload and the available space. The smallest symbol that fits gets
+// the highest error correction level which still leaves at least N
+// pixels per module. Only capacity tables are consulted, so that it's
+// cheap enough to be re-evaluated on every resize.
+class QrClipPolicy
+{
+public:
+    // What the payload needs, per version class and per Micro QR
+    // version. Computed once per payload, off the GUI thread.
+    class Demand
+    {
+    public:
+        Demand();
+        Demand(const QrClipSegmenter&);
+
+        bool isEmpty() const;
+        int minVersion(QRecLevel) const;
+        int minMicroVersion(QRecLevel) const;
+
+    public:
+        int iBits[QrClipSpec::VersionClasses];
+        int iMicroBits[QrClipSpec::MaxMicroVersion]; // -1 if doesn't fit
+    };
+
+    QrClipPolicy(int aBorder = 0, int aModulePixels = 0, bool aMicro = false)
+        : iBorder(aBorder), iModulePixels(aModulePixels), iMicro(aMicro) {}
+
+    bool isEnabled() const;
+    QrClipSymbol::Params select(const Demand&, const QSize&) const;
+
+public:
+    int iBorder;
+    int iModulePixels;  // Zero disables the policy
+    bool iMicro;
+};
+
+#endif // QRCLIP_POLICY_H
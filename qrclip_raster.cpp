@@ -0,0 +1,325 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_raster.h"
+
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define QRCLIP_RASTER_NEON
+#endif
+
+namespace {
+
+// Longest row of a QR code is 177 modules
+const uint MaxModules = 256;
+
+inline
+uchar
+reverseBits(
+    uint aByte)
+{
+    aByte = ((aByte & 0xf0) >> 4) | ((aByte & 0x0f) << 4);
+    aByte = ((aByte & 0xcc) >> 2) | ((aByte & 0x33) << 2);
+    aByte = ((aByte & 0xaa) >> 1) | ((aByte & 0x55) << 1);
+    return (uchar) aByte;
+}
+
+// Appends bits to the scanline, MSB first
+class BitWriter
+{
+public:
+    BitWriter(uchar* aLine, uint aOffset) :
+        iOut(aLine + aOffset / 8),
+        iAcc(0),
+        iBits(aOffset % 8)
+    {}
+
+    inline void put(quint32 aBits, uint aCount)
+    {
+        // aCount is never larger than 32, i.e. it all fits into iAcc
+        iAcc = (iAcc << aCount) | aBits;
+        iBits += aCount;
+        if (iBits >= 32) {
+            iBits -= 32;
+            const quint32 word = (quint32)(iAcc >> iBits);
+
+            iOut[0] = (uchar)(word >> 24);
+            iOut[1] = (uchar)(word >> 16);
+            iOut[2] = (uchar)(word >> 8);
+            iOut[3] = (uchar)word;
+            iOut += 4;
+        }
+    }
+
+    void flush()
+    {
+        while (iBits >= 8) {
+            iBits -= 8;
+            *iOut++ = (uchar)(iAcc >> iBits);
+        }
+        if (iBits) {
+            *iOut = (uchar)(iAcc << (8 - iBits));
+        }
+    }
+
+private:
+    uchar* iOut;
+    quint64 iAcc;
+    uint iBits;
+};
+
+// Maps 4 bits to 4*S bits, repeating each one S times
+template <uint S>
+class NibbleTable
+{
+public:
+    NibbleTable()
+    {
+        for (uint n = 0; n < 16; n++) {
+            quint32 bits = 0;
+
+            for (uint k = 0; k < 4; k++) {
+                bits <<= S;
+                if (n & (8 >> k)) {
+                    bits |= (1u << S) - 1;
+                }
+            }
+            iBits[n] = bits;
+        }
+    }
+
+public:
+    quint32 iBits[16];
+};
+
+// Packs the least significant bits of aCount module bytes into MSB
+// first bitmap, 8 modules per byte
+void
+packModules(
+    const uchar* aModules,
+    uint aCount,
+    uchar* aPacked)
+{
+    uint i = 0;
+
+    memset(aPacked, 0, (aCount + 7) / 8);
+
+#ifdef __AVX2__
+    for (; i + 32 <= aCount; i += 32) {
+        // Shift bit 0 of each byte into the sign bit and collect those
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(aModules + i));
+        const quint32 mask = (quint32) _mm256_movemask_epi8(
+            _mm256_slli_epi16(v, 7));
+        uchar* out = aPacked + i / 8;
+
+        out[0] = reverseBits(mask & 0xff);
+        out[1] = reverseBits((mask >> 8) & 0xff);
+        out[2] = reverseBits((mask >> 16) & 0xff);
+        out[3] = reverseBits(mask >> 24);
+    }
+#endif
+
+#ifdef __SSE2__
+    for (; i + 16 <= aCount; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(aModules + i));
+        const uint mask = (uint) _mm_movemask_epi8(_mm_slli_epi16(v, 7));
+        uchar* out = aPacked + i / 8;
+
+        out[0] = reverseBits(mask & 0xff);
+        out[1] = reverseBits(mask >> 8);
+    }
+#endif
+
+#ifdef QRCLIP_RASTER_NEON
+    static const uint8_t weights[8] = { 0x80, 0x40, 0x20, 0x10, 8, 4, 2, 1 };
+    const uint8x8_t w = vld1_u8(weights);
+    const uint8x8_t one = vdup_n_u8(1);
+
+    for (; i + 8 <= aCount; i += 8) {
+        // Each module contributes its own bit, the sum is the byte
+        const uint8x8_t v = vand_u8(vld1_u8(aModules + i), one);
+
+        aPacked[i / 8] = vaddv_u8(vmul_u8(v, w));
+    }
+#endif
+
+    for (; i < aCount; i++) {
+        if (aModules[i] & 1) {
+            aPacked[i / 8] |= 0x80 >> (i % 8);
+        }
+    }
+}
+
+// Scales 1 to 8, one table lookup per 4 modules
+template <uint S>
+void
+expandBits(
+    const uchar* aModules,
+    uint aCount,
+    uint aOffset,
+    uchar* aLine)
+{
+    static const NibbleTable<S> table;
+    uchar packed[MaxModules / 8];
+    const uint bytes = aCount / 8;
+    const uint rest = aCount % 8;
+    BitWriter out(aLine, aOffset);
+
+    packModules(aModules, aCount, packed);
+    for (uint i = 0; i < bytes; i++) {
+        const uint b = packed[i];
+
+        out.put(table.iBits[b >> 4], 4 * S);
+        out.put(table.iBits[b & 0x0f], 4 * S);
+    }
+
+    for (uint k = 0; k < rest; k++) {
+        out.put((packed[bytes] & (0x80 >> k)) ? ((1u << S) - 1) : 0, S);
+    }
+    out.flush();
+}
+
+// Scales divisible by 8 with byte-aligned offset, no bit shuffling needed
+void
+expandBytes(
+    const uchar* aModules,
+    uint aCount,
+    uint aScale,
+    uchar* aLine)
+{
+    const uint n = aScale / 8;
+    uint i = 0;
+
+    if (n == 1) {
+        // Each module becomes a byte, either 0x00 or 0xff
+#ifdef __AVX2__
+        const __m256i one32 = _mm256_set1_epi8(1);
+
+        for (; i + 32 <= aCount; i += 32) {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)
+                (aModules + i));
+
+            _mm256_storeu_si256((__m256i*)(aLine + i), _mm256_sub_epi8(
+                _mm256_setzero_si256(), _mm256_and_si256(v, one32)));
+        }
+#endif
+#ifdef __SSE2__
+        const __m128i one16 = _mm_set1_epi8(1);
+
+        for (; i + 16 <= aCount; i += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(aModules + i));
+
+            _mm_storeu_si128((__m128i*)(aLine + i), _mm_sub_epi8(
+                _mm_setzero_si128(), _mm_and_si128(v, one16)));
+        }
+#endif
+#ifdef QRCLIP_RASTER_NEON
+        const uint8x16_t one16 = vdupq_n_u8(1);
+
+        for (; i + 16 <= aCount; i += 16) {
+            const uint8x16_t v = vandq_u8(vld1q_u8(aModules + i), one16);
+
+            vst1q_u8(aLine + i, vsubq_u8(vdupq_n_u8(0), v));
+        }
+#endif
+    }
+
+    for (; i < aCount; i++) {
+        memset(aLine + i * n, (aModules[i] & 1) ? 0xff : 0, n);
+    }
+}
+
+// Any other scale
+void
+expandGeneric(
+    const uchar* aModules,
+    uint aCount,
+    uint aScale,
+    uint aOffset,
+    uchar* aLine)
+{
+    BitWriter out(aLine, aOffset);
+
+    for (uint i = 0; i < aCount; i++) {
+        const quint32 bits = (aModules[i] & 1) ? 0xffffffff : 0;
+        uint n = aScale;
+
+        while (n >= 32) {
+            out.put(bits, 32);
+            n -= 32;
+        }
+        if (n) {
+            out.put(bits >> (32 - n), n);
+        }
+    }
+    out.flush();
+}
+
+} // namespace
+
+// static
+void
+QrClipRaster::expandRow(
+    const uchar* aModules,
+    uint aCount,
+    uint aScale,
+    uint aOffset,
+    uchar* aLine)
+{
+    if (!(aScale % 8) && !(aOffset % 8)) {
+        expandBytes(aModules, aCount, aScale, aLine + aOffset / 8);
+    } else if (aCount > MaxModules) {
+        expandGeneric(aModules, aCount, aScale, aOffset, aLine);
+    } else {
+        switch (aScale) {
+        case 1: expandBits<1>(aModules, aCount, aOffset, aLine); break;
+        case 2: expandBits<2>(aModules, aCount, aOffset, aLine); break;
+        case 3: expandBits<3>(aModules, aCount, aOffset, aLine); break;
+        case 4: expandBits<4>(aModules, aCount, aOffset, aLine); break;
+        case 5: expandBits<5>(aModules, aCount, aOffset, aLine); break;
+        case 6: expandBits<6>(aModules, aCount, aOffset, aLine); break;
+        case 7: expandBits<7>(aModules, aCount, aOffset, aLine); break;
+        case 8: expandBits<8>(aModules, aCount, aOffset, aLine); break;
+        default:
+            expandGeneric(aModules, aCount, aScale, aOffset, aLine);
+            break;
+        }
+    }
+}
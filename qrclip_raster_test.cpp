@@ -0,0 +1,164 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+// Checks that every QrClipRaster::expandRow() path (byte copies, nibble
+// tables, SIMD packing and the generic bit writer) produces exactly the
+// same scanline as the obvious pixel by pixel expansion. Exits with
+// non-zero status on the first mismatch.
+
+#include "qrclip_raster.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Longer than any QR code row, to hit the generic fallback too
+const uint MaxCount = 300;
+const uint MaxScale = 16;
+const uint MaxOffset = 16;
+const uint LineSize = (MaxOffset + MaxCount * MaxScale + 7) / 8 + 32;
+
+// Row lengths of interest: QR and Micro QR sizes, SIMD block boundaries
+// and their neighbours, and a couple of oversized ones
+const uint Counts[] = {
+    1, 7, 8, 9, 11, 15, 16, 17, 21, 25, 31, 32, 33, 47, 63, 64, 65,
+    101, 177, 255, 256, 257, MaxCount
+};
+
+// Deterministic pseudo-random modules, with the other bits of each
+// byte set too (expandRow must only look at bit 0)
+void
+makeModules(
+    uchar* aModules,
+    uint aCount,
+    quint32 aSeed)
+{
+    quint32 x = aSeed * 2654435761u + 1;
+
+    for (uint i = 0; i < aCount; i++) {
+        x = x * 1664525u + 1013904223u;
+        aModules[i] = (uchar)(x >> 24);
+    }
+}
+
+void
+expandReference(
+    const uchar* aModules,
+    uint aCount,
+    uint aScale,
+    uint aOffset,
+    uchar* aLine)
+{
+    for (uint i = 0; i < aCount; i++) {
+        if (aModules[i] & 1) {
+            for (uint k = 0; k < aScale; k++) {
+                const uint x = aOffset + i * aScale + k;
+
+                aLine[x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+    }
+}
+
+bool
+check(
+    const uchar* aModules,
+    uint aCount,
+    uint aScale,
+    uint aOffset)
+{
+    uchar expected[LineSize];
+    uchar actual[LineSize];
+
+    memset(expected, 0, sizeof(expected));
+    memset(actual, 0, sizeof(actual));
+    expandReference(aModules, aCount, aScale, aOffset, expected);
+    QrClipRaster::expandRow(aModules, aCount, aScale, aOffset, actual);
+
+    // The whole buffer is compared, nothing may be written past the row
+    for (uint i = 0; i < LineSize; i++) {
+        if (expected[i] != actual[i]) {
+            fprintf(stderr, "Mismatch at byte %u (0x%02x != 0x%02x): "
+                "count %u, scale %u, offset %u\n", i, actual[i],
+                expected[i], aCount, aScale, aOffset);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int
+main(
+    int,
+    char**)
+{
+    uchar modules[MaxCount];
+    uint checked = 0;
+
+    for (uint c = 0; c < sizeof(Counts)/sizeof(Counts[0]); c++) {
+        const uint count = Counts[c];
+
+        makeModules(modules, count, count);
+        for (uint scale = 1; scale <= MaxScale; scale++) {
+            for (uint offset = 0; offset <= MaxOffset; offset++) {
+                if (!check(modules, count, scale, offset)) {
+                    return 1;
+                }
+                checked++;
+            }
+        }
+    }
+
+    // All black and all white rows
+    for (uint scale = 1; scale <= MaxScale; scale++) {
+        memset(modules, 0xff, sizeof(modules));
+        if (!check(modules, MaxCount, scale, 0) ||
+            !check(modules, 177, scale, 4 * scale)) {
+            return 1;
+        }
+        memset(modules, 0xfe, sizeof(modules));
+        if (!check(modules, 177, scale, 4 * scale)) {
+            return 1;
+        }
+        checked += 3;
+    }
+
+    printf("%u rows OK\n", checked);
+    return 0;
+}
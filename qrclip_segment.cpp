@@ -0,0 +1,651 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_segment.h"
+
+#include "qrclip_spec.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#  include <QtCore/QTextCodec>
+#else
+#  include <QtCore/QStringEncoder>
+#endif
+
+#include <limits.h>
+
+namespace {
+
+enum {
+    ModeNum,
+    ModeAn,
+    Mode8,
+    ModeKanji,
+    ModeCount
+};
+
+const QRencodeMode Modes[ModeCount] = {
+    QR_MODE_NUM, QR_MODE_AN, QR_MODE_8, QR_MODE_KANJI
+};
+
+// DP states. Numeric mode packs 3 digits into 10 bits (4 bits for a
+// single digit, 7 bits for two), alphanumeric mode packs 2 characters
+// into 11 bits (6 bits for a single one). Tracking the number of
+// characters modulo 3 and 2 makes every step cost a whole number of
+// bits, and the result exact.
+enum {
+    StateNum0,
+    StateNum1,
+    StateNum2,
+    StateAn0,
+    StateAn1,
+    State8,
+    StateKanji,
+    StateCount
+};
+
+const int StateMode[StateCount] = {
+    ModeNum, ModeNum, ModeNum, ModeAn, ModeAn, Mode8, ModeKanji
+};
+
+// The state a segment continues from, and whether it can start one
+const int StatePrev[StateCount] = {
+    StateNum2, StateNum0, StateNum1, StateAn1, StateAn0, State8, StateKanji
+};
+
+const bool StateStart[StateCount] = {
+    false, true, false, false, true, true, true
+};
+
+const int Infinity = INT_MAX / 2;
+
+// ECI mode indicator and an 8-bit designator (ISO/IEC 18004:2015, 7.4.2)
+const int EciBits = 12;
+
+inline
+bool
+isAlphaNumeric(
+    uint aChar)
+{
+    return (aChar >= '0' && aChar <= '9') || (aChar >= 'A' && aChar <= 'Z') ||
+        aChar == ' ' || aChar == '$' || aChar == '%' || aChar == '*' ||
+        aChar == '+' || aChar == '-' || aChar == '.' || aChar == '/' ||
+        aChar == ':';
+}
+
+class ShiftJisCodec
+{
+public:
+    ShiftJisCodec();
+
+    QByteArray encode(uint);
+
+private:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    QTextCodec* iCodec;
+#else
+    QStringEncoder iEncoder;
+#endif
+};
+
+ShiftJisCodec::ShiftJisCodec() :
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    iCodec(QTextCodec::codecForName("Shift_JIS"))
+#else
+    iEncoder("Shift_JIS", QStringConverter::Flag::Stateless)
+#endif
+{}
+
+// Returns an empty array if the character can't be represented in
+// Shift-JIS or if there's no Shift-JIS codec at all.
+QByteArray
+ShiftJisCodec::encode(
+    uint aChar)
+{
+    QByteArray sjis;
+
+    if (aChar < 0x10000) {
+        const QChar ch((ushort)aChar);
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        if (iCodec) {
+            QTextCodec::ConverterState state(QTextCodec::ConvertInvalidToNull);
+
+            sjis = iCodec->fromUnicode(&ch, 1, &state);
+            if (state.invalidChars) {
+                sjis.clear();
+            }
+        }
+#else
+        if (iEncoder.isValid()) {
+            sjis = iEncoder.encode(QStringView(&ch, 1));
+            if (iEncoder.hasError()) {
+                iEncoder.resetState();
+                sjis.clear();
+            }
+        }
+#endif
+    }
+    return sjis;
+}
+
+// Kanji mode covers double-byte Shift-JIS codes 0x8140-0x9ffc and
+// 0xe040-0xebbf, that's not just kanji but also kana, Greek, Cyrillic,
+// full width Latin letters and a bunch of symbols.
+inline
+quint16
+kanjiCode(
+    const QByteArray& aShiftJis)
+{
+    if (aShiftJis.size() == 2) {
+        const quint16 code = (quint16(uchar(aShiftJis.at(0))) << 8) |
+            uchar(aShiftJis.at(1));
+
+        if ((code >= 0x8140 && code <= 0x9ffc) ||
+            (code >= 0xe040 && code <= 0xebbf)) {
+            return code;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+//===========================================================================
+// QrClipSegmenter
+//===========================================================================
+
+QrClipSegmenter::QrClipSegmenter(
+    const QString& aText)
+{
+    const int n = aText.size();
+    bool ascii = true;
+    ShiftJisCodec sjis;
+
+    for (int c = 0; c < CharsetCount; c++) {
+        Encoding& e = iEncoding[c];
+
+        e.iValid = true;
+        e.iBytes.reserve(n);
+        e.iOffsets.reserve(n + 1);
+        for (int i = 0; i < QrClipSpec::VersionClasses; i++) {
+            e.iBits[i] = -1;
+        }
+    }
+
+    iModes.reserve(n);
+    iKanji.reserve(n);
+    for (int i = 0; i < n; i++) {
+        const QChar ch(aText.at(i));
+
+        if (ch.unicode() < 0x80) {
+            appendChar(ch.unicode(), QByteArray());
+        } else {
+            ascii = false;
+            if (ch.isHighSurrogate() && (i + 1) < n &&
+                aText.at(i + 1).isLowSurrogate()) {
+                appendChar(QChar::surrogateToUcs4(ch, aText.at(++i)),
+                    QByteArray());
+            } else if (ch.isSurrogate()) {
+                // Unpaired surrogate, the same thing QString::toUtf8 does
+                appendChar(QChar::ReplacementCharacter, QByteArray());
+            } else {
+                appendChar(ch.unicode(), sjis.encode(ch.unicode()));
+            }
+        }
+    }
+
+    for (int c = 0; c < CharsetCount; c++) {
+        Encoding& e = iEncoding[c];
+
+        e.iOffsets.append(e.iBytes.size());
+        if (ascii && c != Utf8) {
+            // All three are the same
+            e.iValid = false;
+        }
+    }
+}
+
+void
+QrClipSegmenter::appendChar(
+    uint aChar,
+    const QByteArray& aShiftJis)
+{
+    Encoding& utf8 = iEncoding[Utf8];
+    Encoding& latin1 = iEncoding[Latin1];
+    Encoding& sjis = iEncoding[ShiftJis];
+    const quint16 kanji = kanjiCode(aShiftJis);
+    uchar modes = (1 << Mode8);
+
+    for (int c = 0; c < CharsetCount; c++) {
+        iEncoding[c].iOffsets.append(iEncoding[c].iBytes.size());
+    }
+
+    // Shift-JIS single byte range is JIS X 0201 Roman rather than ASCII,
+    // 0x5c is the yen sign and 0x7e is the overline. Readers disagree on
+    // which one they show, and the codec maps U+00A5 and U+203E there too.
+    // Text with any of those doesn't survive Shift-JIS.
+    if (aChar == 0x5c || aChar == 0x7e || aChar == 0xa5 || aChar == 0x203e) {
+        sjis.iValid = false;
+    }
+
+    if (aChar < 0x80) {
+        for (int c = 0; c < CharsetCount; c++) {
+            iEncoding[c].iBytes.append(char(aChar));
+        }
+        if (aChar >= '0' && aChar <= '9') {
+            modes |= (1 << ModeNum) | (1 << ModeAn);
+        } else if (isAlphaNumeric(aChar)) {
+            modes |= (1 << ModeAn);
+        }
+    } else {
+        if (aChar < 0x800) {
+            utf8.iBytes.append(char(0xc0 | (aChar >> 6)));
+            utf8.iBytes.append(char(0x80 | (aChar & 0x3f)));
+        } else if (aChar < 0x10000) {
+            utf8.iBytes.append(char(0xe0 | (aChar >> 12)));
+            utf8.iBytes.append(char(0x80 | ((aChar >> 6) & 0x3f)));
+            utf8.iBytes.append(char(0x80 | (aChar & 0x3f)));
+        } else {
+            utf8.iBytes.append(char(0xf0 | (aChar >> 18)));
+            utf8.iBytes.append(char(0x80 | ((aChar >> 12) & 0x3f)));
+            utf8.iBytes.append(char(0x80 | ((aChar >> 6) & 0x3f)));
+            utf8.iBytes.append(char(0x80 | (aChar & 0x3f)));
+        }
+
+        if (aChar < 0x100) {
+            latin1.iBytes.append(char(aChar));
+        } else {
+            latin1.iValid = false;
+        }
+
+        if (aShiftJis.isEmpty()) {
+            sjis.iValid = false;
+        } else {
+            sjis.iBytes.append(aShiftJis);
+        }
+    }
+
+    if (kanji) {
+        modes |= (1 << ModeKanji);
+    }
+    iModes.append(modes);
+    iKanji.append(kanji);
+}
+
+// static
+int
+QrClipSegmenter::eci(
+    Charset aCharset)
+{
+    switch (aCharset) {
+    case Latin1: return 3;
+    case ShiftJis: return 20;
+    default: return 26;
+    }
+}
+
+// static
+int
+QrClipSegmenter::segmentBits(
+    const Segment& aSegment,
+    int aVersion,
+    bool aMicro)
+{
+    const int size = aSegment.iData.size();
+    int bits = aMicro ? (QrClipSpec::microModeBits(aVersion) +
+        QrClipSpec::microLengthBits(aSegment.iMode, aVersion)) :
+        (QrClipSpec::ModeBits +
+        QrClipSpec::lengthBits(aSegment.iMode, aVersion));
+
+    switch (aSegment.iMode) {
+    case QR_MODE_NUM:
+        return bits + 10 * (size / 3) + ((size % 3) ? (size % 3) * 3 + 1 : 0);
+    case QR_MODE_AN:
+        return bits + 11 * (size / 2) + 6 * (size % 2);
+    case QR_MODE_KANJI:
+        return bits + 13 * (size / 2);
+    default:
+        return bits + 8 * size;
+    }
+}
+
+// ASCII is the same in all supported charsets, no need for ECI
+// unless there's something else in 8-bit segments.
+// static
+bool
+QrClipSegmenter::needEci(
+    const QList<Segment>& aSegments)
+{
+    for (int i = 0; i < aSegments.size(); i++) {
+        const Segment& segment = aSegments.at(i);
+
+        if (segment.iMode == QR_MODE_8) {
+            const QByteArray& data = segment.iData;
+            const int n = data.size();
+
+            for (int k = 0; k < n; k++) {
+                if (uchar(data.at(k)) >= 0x80) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+inline
+int
+QrClipSegmenter::charBits(
+    const Encoding& aEncoding,
+    int aState,
+    int aIndex) const
+{
+    switch (aState) {
+    case StateNum0:
+    case StateNum2: return 3;
+    case StateNum1: return 4;
+    case StateAn0: return 5;
+    case StateAn1: return 6;
+    case StateKanji: return 13;
+    default: return 8 * (aEncoding.iOffsets.at(aIndex + 1) -
+        aEncoding.iOffsets.at(aIndex));
+    }
+}
+
+bool
+QrClipSegmenter::isEmpty() const
+{
+    return iModes.isEmpty();
+}
+
+// Exact length of the bit stream, including the ECI header
+int
+QrClipSegmenter::bitCount(
+    Charset aCharset,
+    int aVersion) const
+{
+    const Encoding& e = iEncoding[aCharset];
+    const int c = QrClipSpec::versionClass(aVersion);
+
+    if (e.iBits[c] < 0) {
+        const QList<Segment> list(segments(aCharset, aVersion, false));
+        int bits = needEci(list) ? EciBits : 0;
+
+        for (int i = 0; i < list.size(); i++) {
+            bits += segmentBits(list.at(i), aVersion, false);
+        }
+        e.iBits[c] = bits;
+    }
+    return e.iBits[c];
+}
+
+// The charset giving the shortest bit stream for this version
+QrClipSegmenter::Charset
+QrClipSegmenter::charset(
+    int aVersion) const
+{
+    Charset best = Utf8;
+
+    for (int c = Utf8 + 1; c < CharsetCount; c++) {
+        if (iEncoding[c].iValid &&
+            bitCount(Charset(c), aVersion) < bitCount(best, aVersion)) {
+            best = Charset(c);
+        }
+    }
+    return best;
+}
+
+int
+QrClipSegmenter::bitCount(
+    int aVersion) const
+{
+    return bitCount(charset(aVersion), aVersion);
+}
+
+// Returns the smallest version that fits the text, zero if none does
+int
+QrClipSegmenter::minVersion(
+    QRecLevel aLevel) const
+{
+    if (!isEmpty()) {
+        for (int c = 0; c < QrClipSpec::VersionClasses; c++) {
+            const int bits = bitCount(QrClipSpec::firstVersion(c));
+            const int last = QrClipSpec::lastVersion(c);
+
+            for (int v = QrClipSpec::firstVersion(c); v <= last; v++) {
+                if (QrClipSpec::dataBits(v, aLevel) >= bits) {
+                    return v;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+QList<QrClipSegmenter::Segment>
+QrClipSegmenter::segments(
+    int aVersion) const
+{
+    return segments(charset(aVersion), aVersion, false);
+}
+
+// Micro QR doesn't support ECI, so 8-bit segments are limited to ASCII.
+// Returns -1 if the text can't be encoded by this Micro QR version.
+int
+QrClipSegmenter::microBitCount(
+    int aVersion) const
+{
+    const QList<Segment> list(segments(Utf8, aVersion, true));
+
+    if (!list.isEmpty() && !needEci(list)) {
+        int bits = 0;
+
+        for (int i = 0; i < list.size(); i++) {
+            bits += segmentBits(list.at(i), aVersion, true);
+        }
+        return bits;
+    }
+    return -1;
+}
+
+// Dynamic programming over the characters. For each character and each
+// state, the cheapest way to encode the text up to and including this
+// character with the last segment being in this state. A segment either
+// continues, or a new one starts after the cheapest of the previous ones.
+// The list is empty if the text can't be encoded at all, which may only
+// happen with Micro QR.
+QList<QrClipSegmenter::Segment>
+QrClipSegmenter::segments(
+    Charset aCharset,
+    int aVersion,
+    bool aMicro) const
+{
+    const Encoding& e = iEncoding[aCharset];
+    QList<Segment> list;
+    const int n = iModes.size();
+
+    if (n > 0) {
+        QVector<uchar> from(n * StateCount);
+        int header[StateCount];
+        int cost[StateCount];
+        uchar allowed = 0;
+        int s, best = 0;
+
+        for (s = 0; s < StateCount; s++) {
+            const int m = StateMode[s];
+            const int lengthBits = aMicro ?
+                QrClipSpec::microLengthBits(Modes[m], aVersion) :
+                QrClipSpec::lengthBits(Modes[m], aVersion);
+
+            // Unsupported modes are treated as unusable
+            if (lengthBits) {
+                header[s] = lengthBits + (aMicro ?
+                    QrClipSpec::microModeBits(aVersion) :
+                    int(QrClipSpec::ModeBits));
+                allowed |= (1 << m);
+            } else {
+                header[s] = Infinity;
+            }
+            cost[s] = (StateStart[s] && (iModes.at(0) & allowed & (1 << m))) ?
+                (header[s] + charBits(e, s, 0)) : Infinity;
+        }
+
+        for (int i = 1; i < n; i++) {
+            const uchar modes = iModes.at(i) & allowed;
+            uchar* prev = from.data() + i * StateCount;
+            int next[StateCount];
+
+            for (best = 0, s = 1; s < StateCount; s++) {
+                if (cost[s] < cost[best]) {
+                    best = s;
+                }
+            }
+            for (s = 0; s < StateCount; s++) {
+                if (modes & (1 << StateMode[s])) {
+                    const int p = StatePrev[s];
+
+                    next[s] = cost[p];
+                    prev[s] = p;
+                    if (StateStart[s] && cost[best] + header[s] < next[s]) {
+                        next[s] = cost[best] + header[s];
+                        prev[s] = best;
+                    }
+                    next[s] += charBits(e, s, i);
+                } else {
+                    next[s] = Infinity;
+                }
+            }
+            for (s = 0; s < StateCount; s++) {
+                cost[s] = next[s];
+            }
+        }
+
+        // Walk back, then collect characters into segments
+        QVector<uchar> states(n);
+
+        for (best = 0, s = 1; s < StateCount; s++) {
+            if (cost[s] < cost[best]) {
+                best = s;
+            }
+        }
+        if (cost[best] >= Infinity) {
+            return list;
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            states[i] = best;
+            best = from.at(i * StateCount + best);
+        }
+
+        for (int i = 0; i < n; i++) {
+            const int m = StateMode[states.at(i)];
+
+            // A starting state following anything other than its own
+            // predecessor begins a new segment
+            if (i == 0 || (StateStart[states.at(i)] &&
+                states.at(i - 1) != StatePrev[states.at(i)])) {
+                Segment segment;
+
+                segment.iMode = Modes[m];
+                list.append(segment);
+            }
+
+            QByteArray& data = list.last().iData;
+
+            if (m == ModeKanji) {
+                data.append(char(iKanji.at(i) >> 8));
+                data.append(char(iKanji.at(i)));
+            } else {
+                const int start = e.iOffsets.at(i);
+
+                data.append(e.iBytes.constData() + start,
+                    e.iOffsets.at(i + 1) - start);
+            }
+        }
+    }
+    return list;
+}
+
+QRinput*
+QrClipSegmenter::makeInput(
+    int aVersion,
+    QRecLevel aLevel) const
+{
+    QRinput* input = QRinput_new2(aVersion, aLevel);
+
+    if (input) {
+        const Charset cs = charset(aVersion);
+        const QList<Segment> list(segments(cs, aVersion, false));
+
+        if (needEci(list) && QRinput_appendECIheader(input, eci(cs)) < 0) {
+            QRinput_free(input);
+            return nullptr;
+        }
+
+        for (int i = 0; i < list.size(); i++) {
+            const Segment& segment = list.at(i);
+
+            if (QRinput_append(input, segment.iMode, segment.iData.size(),
+                (const uchar*)segment.iData.constData()) < 0) {
+                QRinput_free(input);
+                return nullptr;
+            }
+        }
+    }
+    return input;
+}
+
+QRinput*
+QrClipSegmenter::makeMicroInput(
+    int aVersion,
+    QRecLevel aLevel) const
+{
+    const QList<Segment> list(segments(Utf8, aVersion, true));
+    QRinput* input = list.isEmpty() ? nullptr :
+        QRinput_newMQR(aVersion, aLevel);
+
+    if (input) {
+        for (int i = 0; i < list.size(); i++) {
+            const Segment& segment = list.at(i);
+
+            if (QRinput_append(input, segment.iMode, segment.iData.size(),
+                (const uchar*)segment.iData.constData()) < 0) {
+                QRinput_free(input);
+                return nullptr;
+            }
+        }
+    }
+    return input;
+}
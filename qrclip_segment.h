@@ -0,0 +1,108 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_SEGMENT_H
+#define QRCLIP_SEGMENT_H
+
+#include "qrclip_spec.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// Splits the text into numeric, alphanumeric, 8-bit and kanji segments
+// so that the encoded bit stream is as short as possible. The split
+// depends on the size of the character count indicators, and those
+// depend on the version. Versions 1-9, 10-26 and 27-40 are therefore
+// optimized separately. So is each Micro QR version.
+//
+// 8-bit segments can be in ISO-8859-1, Shift-JIS or UTF-8, whichever
+// is the shortest. Non-ASCII bytes are announced by an ECI header.
+class QrClipSegmenter
+{
+public:
+    enum Charset {
+        Utf8,
+        Latin1,
+        ShiftJis,
+        CharsetCount
+    };
+
+    class Segment
+    {
+    public:
+        QRencodeMode iMode;
+        QByteArray iData;
+    };
+
+    QrClipSegmenter(const QString&);
+
+    bool isEmpty() const;
+    Charset charset(int) const;
+    int bitCount(int) const;
+    int minVersion(QRecLevel) const;
+    int microBitCount(int) const;
+    QList<Segment> segments(int) const;
+    QRinput* makeInput(int, QRecLevel) const;
+    QRinput* makeMicroInput(int, QRecLevel) const;
+
+    static int eci(Charset);
+
+private:
+    class Encoding
+    {
+    public:
+        bool iValid;
+        QByteArray iBytes;          // 8-bit representation of the text
+        QVector<int> iOffsets;      // Start of each character in iBytes
+        mutable int iBits[QrClipSpec::VersionClasses]; // -1 if unknown
+    };
+
+    void appendChar(uint, const QByteArray&);
+    int charBits(const Encoding&, int, int) const;
+    int bitCount(Charset, int) const;
+    QList<Segment> segments(Charset, int, bool) const;
+    static bool needEci(const QList<Segment>&);
+    static int segmentBits(const Segment&, int, bool);
+
+private:
+    QVector<uchar> iModes;      // Modes applicable to each character
+    QVector<quint16> iKanji;    // Shift-JIS code, for kanji characters
+    Encoding iEncoding[CharsetCount];
+};
+
+#endif // QRCLIP_SEGMENT_H
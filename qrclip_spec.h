@@ -0,0 +1,191 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_SPEC_H
+#define QRCLIP_SPEC_H
+
+#include <qrencode.h>
+
+// Capacities of QR code and Micro QR code symbols
+// (ISO/IEC 18004:2015, Table 7 and 3)
+class QrClipSpec
+{
+public:
+    enum {
+        MinVersion = 1,
+        MaxVersion = 40,
+        MaxMicroVersion = 4,
+        VersionClasses = 3,
+        ModeBits = 4,
+        StructuredAppendBits = 20,
+        MaxStructuredAppendSymbols = 16
+    };
+
+    // Symbol size in modules, without the quiet zone
+    static constexpr int width(int aVersion)
+        { return 17 + 4 * aVersion; }
+
+    // Number of bits available for the data
+    static constexpr int dataBits(int aVersion, QRecLevel aLevel)
+        { return 8 * DataCodewords[aVersion - 1][aLevel]; }
+
+    // Size of the character count indicator
+    static constexpr int lengthBits(QRencodeMode aMode, int aVersion)
+        { return (aMode == QR_MODE_NUM) ? lengthBits(aVersion, 10, 12, 14) :
+            (aMode == QR_MODE_AN) ? lengthBits(aVersion, 9, 11, 13) :
+            (aMode == QR_MODE_KANJI) ? lengthBits(aVersion, 8, 10, 12) :
+            lengthBits(aVersion, 8, 16, 16); }
+
+    // Maximum number of digits in a single numeric mode segment
+    static constexpr int numericCapacity(int aVersion, QRecLevel aLevel)
+        { return numericCapacity(dataBits(aVersion, aLevel) - ModeBits -
+            lengthBits(QR_MODE_NUM, aVersion)); }
+
+    // No mode takes less than 10 bits per 3 characters, and a UTF-16
+    // code unit is at least one character. Longer text is never going
+    // to fit, no matter how it's encoded.
+    static constexpr int maxLength()
+        { return numericCapacity(MaxVersion, QR_ECLEVEL_L); }
+
+    // Same thing for a sequence of structured append symbols, which are
+    // encoded in 8-bit mode. A UTF-16 code unit takes at least one byte.
+    static constexpr int maxStructuredLength(int aSymbols, QRecLevel aLevel)
+        { return aSymbols * byteCapacity(MaxVersion, aLevel,
+            StructuredAppendBits); }
+
+    // Character count indicators have the same size within a class
+    static constexpr int versionClass(int aVersion)
+        { return (aVersion < 10) ? 0 : (aVersion < 27) ? 1 : 2; }
+
+    static constexpr int firstVersion(int aClass)
+        { return (aClass == 0) ? 1 : (aClass == 1) ? 10 : 27; }
+
+    static constexpr int lastVersion(int aClass)
+        { return (aClass == 0) ? 9 : (aClass == 1) ? 26 : 40; }
+
+    // Micro QR symbol size (M1 to M4), without the quiet zone
+    static constexpr int microWidth(int aVersion)
+        { return 9 + 2 * aVersion; }
+
+    // Zero if the version doesn't support this error correction level
+    static constexpr int microDataBits(int aVersion, QRecLevel aLevel)
+        { return MicroDataBits[aVersion - 1][aLevel]; }
+
+    // Micro QR mode indicators are from 0 (M1) to 3 (M4) bits long
+    static constexpr int microModeBits(int aVersion)
+        { return aVersion - 1; }
+
+    // Zero if the version doesn't support this mode
+    static constexpr int microLengthBits(QRencodeMode aMode, int aVersion)
+        { return (aMode == QR_MODE_NUM) ? (aVersion + 2) :
+            (aMode == QR_MODE_AN) ? ((aVersion >= 2) ? (aVersion + 1) : 0) :
+            (aMode == QR_MODE_KANJI) ? ((aVersion >= 3) ? aVersion : 0) :
+            (aVersion >= 3) ? (aVersion + 1) : 0; }
+
+    // Maximum number of bytes in a single 8-bit mode segment, after
+    // aOverhead bits taken by something else (e.g. headers)
+    static constexpr int byteCapacity(int aVersion, QRecLevel aLevel,
+        int aOverhead = 0)
+        { return (dataBits(aVersion, aLevel) - aOverhead - ModeBits -
+            lengthBits(QR_MODE_8, aVersion)) / 8; }
+
+private:
+    static constexpr int numericCapacity(int aBits)
+        { return 3 * (aBits / 10) + ((aBits % 10 >= 7) ? 2 :
+            (aBits % 10 >= 4) ? 1 : 0); }
+
+    static constexpr int lengthBits(int aVersion, int aSmall, int aMedium,
+        int aLarge)
+        { return (aVersion < 10) ? aSmall : (aVersion < 27) ? aMedium :
+            aLarge; }
+
+    // Number of data codewords, per version and error correction level
+    static constexpr short DataCodewords[MaxVersion][4] = {
+        //  L     M     Q     H
+        {   19,   16,   13,    9 }, // 1
+        {   34,   28,   22,   16 }, // 2
+        {   55,   44,   34,   26 }, // 3
+        {   80,   64,   48,   36 }, // 4
+        {  108,   86,   62,   46 }, // 5
+        {  136,  108,   76,   60 }, // 6
+        {  156,  124,   88,   66 }, // 7
+        {  194,  154,  110,   86 }, // 8
+        {  232,  182,  132,  100 }, // 9
+        {  274,  216,  154,  122 }, // 10
+        {  324,  254,  180,  140 }, // 11
+        {  370,  290,  206,  158 }, // 12
+        {  428,  334,  244,  180 }, // 13
+        {  461,  365,  261,  197 }, // 14
+        {  523,  415,  295,  223 }, // 15
+        {  589,  453,  325,  253 }, // 16
+        {  647,  507,  367,  283 }, // 17
+        {  721,  563,  397,  313 }, // 18
+        {  795,  627,  445,  341 }, // 19
+        {  861,  669,  485,  385 }, // 20
+        {  932,  714,  512,  406 }, // 21
+        { 1006,  782,  568,  442 }, // 22
+        { 1094,  860,  614,  464 }, // 23
+        { 1174,  914,  664,  514 }, // 24
+        { 1276, 1000,  718,  538 }, // 25
+        { 1370, 1062,  754,  596 }, // 26
+        { 1468, 1128,  808,  628 }, // 27
+        { 1531, 1193,  871,  661 }, // 28
+        { 1631, 1267,  911,  701 }, // 29
+        { 1735, 1373,  985,  745 }, // 30
+        { 1843, 1455, 1033,  793 }, // 31
+        { 1955, 1541, 1115,  845 }, // 32
+        { 2071, 1631, 1171,  901 }, // 33
+        { 2191, 1725, 1231,  961 }, // 34
+        { 2306, 1812, 1286,  986 }, // 35
+        { 2434, 1914, 1354, 1054 }, // 36
+        { 2566, 1992, 1426, 1096 }, // 37
+        { 2702, 2102, 1502, 1142 }, // 38
+        { 2812, 2216, 1582, 1222 }, // 39
+        { 2956, 2334, 1666, 1276 }, // 40
+    };
+
+    // Number of data bits in Micro QR symbols. M1 and M3 end with
+    // a 4-bit codeword, hence not a multiple of 8.
+    static constexpr short MicroDataBits[MaxMicroVersion][4] = {
+        //  L    M    Q    H
+        {  20,   0,   0,   0 }, // M1
+        {  40,  32,   0,   0 }, // M2
+        {  84,  68,   0,   0 }, // M3
+        { 128, 112,  80,   0 }, // M4
+    };
+};
+
+#endif // QRCLIP_SPEC_H
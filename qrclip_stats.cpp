@@ -0,0 +1,180 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_stats.h"
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+namespace {
+
+const char* const CounterNames[QrClipStats::CounterCount] = {
+    "clipboard_fetches",
+    "encodes",
+    "cache_hits",
+    "cache_misses",
+    "renders",
+    "paints",
+    "config_saves",
+    "stalls"
+};
+
+class Histogram
+{
+public:
+    void record(qint64);
+    QJsonObject toJson() const;
+
+public:
+    QAtomicInt iBuckets[QrClipStats::Buckets];
+    QAtomicInteger<qint64> iCount;
+    QAtomicInteger<qint64> iTotal;
+    QAtomicInteger<qint64> iMax;
+};
+
+class Stats
+{
+public:
+    Stats() { iUptime.start(); }
+
+public:
+    QElapsedTimer iUptime;
+    QAtomicInteger<qint64> iCounters[QrClipStats::CounterCount];
+    Histogram iStages[QrClipStageCount];
+};
+
+Q_GLOBAL_STATIC(Stats, stats)
+
+void
+Histogram::record(
+    qint64 aMicroseconds)
+{
+    int bucket = 0;
+
+    while (bucket < QrClipStats::Buckets - 1 &&
+        aMicroseconds >= (Q_INT64_C(1) << bucket)) {
+        bucket++;
+    }
+
+    iBuckets[bucket].fetchAndAddRelaxed(1);
+    iCount.fetchAndAddRelaxed(1);
+    iTotal.fetchAndAddRelaxed(aMicroseconds);
+
+    // Lock-free maximum
+    qint64 max = iMax.loadAcquire();
+
+    while (aMicroseconds > max &&
+        !iMax.testAndSetRelaxed(max, aMicroseconds, max)) {}
+}
+
+QJsonObject
+Histogram::toJson() const
+{
+    QJsonObject json;
+    QJsonArray buckets;
+
+    // Only the non-empty buckets, tagged with their upper bound
+    for (int i = 0; i < QrClipStats::Buckets; i++) {
+        const int count = iBuckets[i].loadAcquire();
+
+        if (count) {
+            QJsonObject bucket;
+
+            if (i < QrClipStats::Buckets - 1) {
+                bucket.insert("lt_us", double(Q_INT64_C(1) << i));
+            }
+            bucket.insert("count", count);
+            buckets.append(bucket);
+        }
+    }
+
+    json.insert("count", double(iCount.loadAcquire()));
+    json.insert("total_us", double(iTotal.loadAcquire()));
+    json.insert("max_us", double(iMax.loadAcquire()));
+    json.insert("buckets", buckets);
+    return json;
+}
+
+} // namespace
+
+//===========================================================================
+// QrClipStats
+//===========================================================================
+
+// static
+void
+QrClipStats::count(
+    Counter aCounter)
+{
+    stats()->iCounters[aCounter].fetchAndAddRelaxed(1);
+}
+
+// static
+void
+QrClipStats::record(
+    QrClipStage aStage,
+    qint64 aNanoseconds)
+{
+    stats()->iStages[aStage].record(aNanoseconds / 1000);
+}
+
+// static
+QByteArray
+QrClipStats::snapshot()
+{
+    const Stats* s = stats();
+    QJsonObject counters;
+    QJsonObject stages;
+    QJsonObject json;
+
+    for (int i = 0; i < CounterCount; i++) {
+        counters.insert(CounterNames[i],
+            double(s->iCounters[i].loadAcquire()));
+    }
+
+    for (int i = 0; i < QrClipStageCount; i++) {
+        stages.insert(QrClipStageTimer::name(QrClipStage(i)),
+            s->iStages[i].toJson());
+    }
+
+    json.insert("uptime_ms", double(s->iUptime.elapsed()));
+    json.insert("counters", counters);
+    json.insert("stages", stages);
+    return QJsonDocument(json).toJson();
+}
@@ -0,0 +1,630 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_stream.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_spec.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QQueue>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Frame layout (all numbers are big-endian):
+//
+//   0     'Q'
+//   1     flags: 0x80 = last segment, 0x40 = systematic (plain) block
+//   2..5  block index for systematic frames, otherwise the PRNG seed
+//   6..9  segment index
+//  10..11 number of blocks in the segment (K)
+//  12..15 segment size in bytes
+//  16..   block data
+//
+// For non-systematic frames, the xorshift32 generator seeded with the
+// seed from the header first picks the degree d (ideal soliton), then
+// d distinct blocks with a partial Fisher-Yates shuffle of 0..K-1. The
+// frame contains XOR of those blocks, the last one is zero-padded.
+
+namespace {
+
+const int FrameVersion = 15;
+const QRecLevel FrameLevel = QR_ECLEVEL_M;
+const int HeaderSize = 16;
+const int BlockSize = QrClipSpec::byteCapacity(FrameVersion, FrameLevel) -
+    HeaderSize;
+const int MaxBlocks = 1024;
+const int SegmentSize = BlockSize * MaxBlocks;
+const int StdinSegments = 4; // How many stdin segments are kept around
+const int MaxFps = 60;
+const uchar FlagLastSegment = 0x80;
+const uchar FlagSystematic = 0x40;
+
+class Random
+{
+public:
+    Random(quint32 aSeed) : iState(aSeed ? aSeed : 1) {}
+
+    quint32 next()
+    {
+        iState ^= iState << 13;
+        iState ^= iState >> 17;
+        iState ^= iState << 5;
+        return iState;
+    }
+
+    // (0, 1]
+    double uniform()
+        { return next() / 4294967295.0; }
+
+private:
+    quint32 iState;
+};
+
+inline
+void
+putNumber(
+    uchar* aDest,
+    quint32 aValue,
+    int aSize)
+{
+    for (int i = aSize - 1; i >= 0; i--) {
+        aDest[i] = (uchar) aValue;
+        aValue >>= 8;
+    }
+}
+
+} // namespace
+
+//===========================================================================
+// QrClipStream::Source
+//===========================================================================
+
+class QrClipStream::Source
+{
+public:
+    virtual ~Source() = default;
+    virtual bool isValid() const = 0;
+
+    // Where the stream starts over after the last segment
+    virtual int firstSegment() const { return 0; }
+
+    // Returns false if there's no such segment (or no data at all)
+    virtual bool segment(int, QByteArray*, bool*, const QAtomicInt&) = 0;
+};
+
+//===========================================================================
+// QrClipStream::FileSource
+//===========================================================================
+
+class QrClipStream::FileSource :
+    public QrClipStream::Source
+{
+public:
+    FileSource(const QString&);
+
+    bool isValid() const override;
+    bool segment(int, QByteArray*, bool*, const QAtomicInt&) override;
+
+private:
+    QFile iFile;
+    qint64 iSize;
+    const uchar* iData;
+};
+
+QrClipStream::FileSource::FileSource(
+    const QString& aFileName) :
+    iFile(aFileName),
+    iSize(0),
+    iData(nullptr)
+{
+    if (!iFile.open(QIODevice::ReadOnly)) {
+        WARN("Failed to open" << qPrintable(aFileName) << iFile.errorString());
+    } else {
+        iSize = iFile.size();
+        if (iSize > 0) {
+            // Pages are faulted in by the producer thread, as needed
+            iData = iFile.map(0, iSize);
+            if (!iData) {
+                WARN("Failed to map" << qPrintable(aFileName) <<
+                    iFile.errorString());
+            }
+        }
+    }
+}
+
+bool
+QrClipStream::FileSource::isValid() const
+{
+    return iData != nullptr;
+}
+
+bool
+QrClipStream::FileSource::segment(
+    int aIndex,
+    QByteArray* aData,
+    bool* aLast,
+    const QAtomicInt&)
+{
+    const qint64 start = qint64(aIndex) * SegmentSize;
+
+    if (iData && start < iSize) {
+        const int size = (int) qMin(iSize - start, qint64(SegmentSize));
+
+        *aData = QByteArray::fromRawData((const char*)iData + start, size);
+        *aLast = (start + size >= iSize);
+        return true;
+    }
+    return false;
+}
+
+//===========================================================================
+// QrClipStream::StdinSource
+//===========================================================================
+
+class QrClipStream::StdinSource :
+    public QrClipStream::Source
+{
+public:
+    StdinSource();
+
+    bool isValid() const override;
+    int firstSegment() const override;
+    bool segment(int, QByteArray*, bool*, const QAtomicInt&) override;
+
+private:
+    bool readSegment(const QAtomicInt&);
+
+private:
+    QList<QByteArray> iSegments;
+    QByteArray iAhead;
+    int iFirst;
+    bool iEof;
+};
+
+QrClipStream::StdinSource::StdinSource() :
+    iFirst(0),
+    iEof(false)
+{}
+
+bool
+QrClipStream::StdinSource::isValid() const
+{
+    return true;
+}
+
+int
+QrClipStream::StdinSource::firstSegment() const
+{
+    return iFirst;
+}
+
+bool
+QrClipStream::StdinSource::readSegment(
+    const QAtomicInt& aStop)
+{
+    // One byte more than fits into a segment is requested, so that a
+    // segment ending right at the end of the input is known to be the
+    // last one. The extra byte (if any) starts the next segment.
+    const int max = SegmentSize + 1;
+    QByteArray buf(max, 0);
+    int size = iAhead.size();
+
+    memcpy(buf.data(), iAhead.constData(), size);
+    iAhead.clear();
+
+    // Poll with a timeout, so that the producer thread can be stopped
+    // while waiting for the input
+    while (size < max && !aStop.loadAcquire()) {
+        struct pollfd fd;
+
+        fd.fd = STDIN_FILENO;
+        fd.events = POLLIN;
+        fd.revents = 0;
+        if (poll(&fd, 1, 100) > 0) {
+            const ssize_t n = read(STDIN_FILENO, buf.data() + size,
+                max - size);
+
+            if (n > 0) {
+                size += n;
+            } else if (!n || errno != EINTR) {
+                iEof = true;
+                break;
+            }
+        }
+    }
+
+    if (size > SegmentSize) {
+        iAhead = buf.mid(SegmentSize);
+        size = SegmentSize;
+    }
+
+    if (size > 0) {
+        buf.resize(size);
+        iSegments.append(buf);
+        DBG("Read segment" << (iFirst + iSegments.size()) << size << "bytes");
+
+        // The older segments have already been sent, only the most
+        // recent ones are repeated after the input ends
+        while (iSegments.size() > StdinSegments) {
+            iSegments.removeFirst();
+            iFirst++;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool
+QrClipStream::StdinSource::segment(
+    int aIndex,
+    QByteArray* aData,
+    bool* aLast,
+    const QAtomicInt& aStop)
+{
+    const int end = iFirst + iSegments.size();
+
+    if (aIndex == end && !iEof) {
+        readSegment(aStop);
+    }
+    if (aIndex >= iFirst && aIndex < iFirst + iSegments.size()) {
+        *aData = iSegments.at(aIndex - iFirst);
+        *aLast = iEof && (aIndex == iFirst + iSegments.size() - 1);
+        return true;
+    }
+    return false;
+}
+
+//===========================================================================
+// QrClipStream::Producer
+//===========================================================================
+
+class QrClipStream::Producer :
+    public QThread
+{
+public:
+    class Frame {
+    public:
+        Frame() : iNewBytes(0), iComplete(false) {}
+
+    public:
+        QrClipSymbol iCode;
+        QString iLabel;
+        int iNewBytes;      // Input not sent before, in this frame
+        bool iComplete;     // The whole input has been sent
+    };
+
+    Producer(Source*, int, QObject*);
+    ~Producer() override;
+
+    bool take(Frame*);
+
+protected:
+    void run() override;
+
+private:
+    QByteArray makeFrame(const QByteArray&, int, int, bool, int, quint32);
+    void put(const Frame&);
+
+private:
+    Source* iSource;
+    const int iDepth;
+    QAtomicInt iStop;
+    QMutex iMutex;
+    QWaitCondition iNotFull;
+    QQueue<Frame> iQueue;
+};
+
+QrClipStream::Producer::Producer(
+    Source* aSource,
+    int aDepth,
+    QObject* aParent) :
+    QThread(aParent),
+    iSource(aSource),
+    iDepth(aDepth)
+{}
+
+QrClipStream::Producer::~Producer()
+{
+    iStop.storeRelease(1);
+    iMutex.lock();
+    iNotFull.wakeAll();
+    iMutex.unlock();
+    wait();
+    delete iSource;
+}
+
+bool
+QrClipStream::Producer::take(
+    Frame* aFrame)
+{
+    QMutexLocker lock(&iMutex);
+
+    if (iQueue.isEmpty()) {
+        return false;
+    } else {
+        *aFrame = iQueue.dequeue();
+        iNotFull.wakeOne();
+        return true;
+    }
+}
+
+void
+QrClipStream::Producer::put(
+    const Frame& aFrame)
+{
+    QMutexLocker lock(&iMutex);
+
+    while (iQueue.size() >= iDepth && !iStop.loadAcquire()) {
+        iNotFull.wait(&iMutex);
+    }
+    iQueue.enqueue(aFrame);
+}
+
+QByteArray
+QrClipStream::Producer::makeFrame(
+    const QByteArray& aSegment,
+    int aSegmentIndex,
+    int aBlockCount,
+    bool aLast,
+    int aBlock,
+    quint32 aSeed)
+{
+    QByteArray frame(HeaderSize + BlockSize, 0);
+    uchar* header = (uchar*) frame.data();
+    uchar* dest = header + HeaderSize;
+    const uchar* src = (const uchar*) aSegment.constData();
+    const int size = aSegment.size();
+
+    header[0] = 'Q';
+    header[1] = (aLast ? FlagLastSegment : 0) | (aBlock >= 0 ? FlagSystematic : 0);
+    putNumber(header + 2, aBlock >= 0 ? aBlock : aSeed, 4);
+    putNumber(header + 6, aSegmentIndex, 4);
+    putNumber(header + 10, aBlockCount, 2);
+    putNumber(header + 12, size, 4);
+
+    if (aBlock >= 0) {
+        const int offset = aBlock * BlockSize;
+
+        memcpy(dest, src + offset, qMin(BlockSize, size - offset));
+    } else {
+        Random random(aSeed);
+        const double u = random.uniform();
+        const int degree = (u <= 1.0 / aBlockCount) ? 1 : qMin(aBlockCount,
+            (int) ceil(1.0 / (1.0 + 1.0 / aBlockCount - u)));
+        QVector<int> blocks(aBlockCount);
+
+        for (int i = 0; i < aBlockCount; i++) {
+            blocks[i] = i;
+        }
+
+        for (int i = 0; i < degree; i++) {
+            const int j = i + (int)(random.next() % quint32(aBlockCount - i));
+            const int block = blocks.at(j);
+            const int offset = block * BlockSize;
+            const int n = qMin(BlockSize, size - offset);
+
+            blocks[j] = blocks.at(i);
+            blocks[i] = block;
+            for (int k = 0; k < n; k++) {
+                dest[k] ^= src[offset + k];
+            }
+        }
+    }
+    return frame;
+}
+
+void
+QrClipStream::Producer::run()
+{
+    const QrClipSymbol::Params params(FrameVersion, FrameLevel);
+    quint32 seed = 1;
+    int index = 0;
+    bool firstPass = true;
+
+    while (!iStop.loadAcquire()) {
+        QByteArray segment;
+        bool last = false;
+
+        if (!iSource->segment(index, &segment, &last, iStop)) {
+            const int first = iSource->firstSegment();
+
+            if (index == first) {
+                DBG("Nothing to stream");
+                break;
+            }
+
+            // Start over, nothing new from now on
+            index = first;
+            firstPass = false;
+            continue;
+        }
+
+        // Each segment gets K systematic frames followed by K/2 frames
+        // with random combinations of blocks. The receiver can recover
+        // the segment from any (slightly more than) K frames.
+        const int k = qMax((segment.size() + BlockSize - 1) / BlockSize, 1);
+        const int n = k + (k + 1) / 2;
+
+        for (int i = 0; i < n && !iStop.loadAcquire(); i++) {
+            Frame frame;
+
+            if (i < k) {
+                frame.iCode = QrClipSymbol::makeBinary(makeFrame(segment,
+                    index, k, last, i, 0), params);
+                frame.iLabel = QString("Segment %1, block %2/%3").
+                    arg(index + 1).arg(i + 1).arg(k);
+                if (firstPass) {
+                    frame.iNewBytes = qMin(BlockSize, segment.size() -
+                        i * BlockSize);
+                    frame.iComplete = last && (i == k - 1);
+                }
+            } else {
+                frame.iCode = QrClipSymbol::makeBinary(makeFrame(segment,
+                    index, k, last, -1, seed), params);
+                frame.iLabel = QString("Segment %1, mix %2").
+                    arg(index + 1).arg(seed);
+                if (!++seed) {
+                    seed = 1;
+                }
+            }
+
+            if (frame.iCode.isNull()) {
+                WARN("Failed to encode frame");
+            } else {
+                put(frame);
+            }
+        }
+        index++;
+    }
+}
+
+//===========================================================================
+// QrClipStream::Data
+//===========================================================================
+
+class QrClipStream::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Data(Source*, int, QrClipStream*);
+
+private Q_SLOTS:
+    void onFrameTimer();
+
+public:
+    const bool iValid;
+    Producer* iProducer;
+    QTimer* iFrameTimer;
+    QElapsedTimer iThroughputTimer;
+    qint64 iBytes;
+    bool iComplete;
+    int iUnderruns;
+};
+
+QrClipStream::Data::Data(
+    Source* aSource,
+    int aFps,
+    QrClipStream* aStream) :
+    QObject(aStream),
+    iValid(aSource->isValid()),
+    // Try to stay two seconds ahead
+    iProducer(new Producer(aSource, 2 * aFps, this)),
+    iFrameTimer(new QTimer(this)),
+    iBytes(0),
+    iComplete(false),
+    iUnderruns(0)
+{
+    iFrameTimer->setTimerType(Qt::PreciseTimer);
+    iFrameTimer->setInterval(1000 / aFps);
+    connect(iFrameTimer, &QTimer::timeout, this, &Data::onFrameTimer);
+    if (iValid) {
+        DBG("Streaming at" << aFps << "fps," << BlockSize << "bytes per frame");
+        iProducer->start();
+        iFrameTimer->start();
+        iThroughputTimer.start();
+    }
+}
+
+void
+QrClipStream::Data::onFrameTimer()
+{
+    QrClipStream* stream = qobject_cast<QrClipStream*>(parent());
+    Producer::Frame frame;
+
+    if (iProducer->take(&frame)) {
+        // Only the input counts, not the repair frames and not the
+        // frames repeating what has already been sent
+        iBytes += frame.iNewBytes;
+        Q_EMIT stream->frame(frame.iCode, frame.iLabel);
+    } else if (!iProducer->isFinished()) {
+        // The producer isn't keeping up, the current frame stays
+        DBG("Stream underrun" << ++iUnderruns);
+    }
+
+    if (!iComplete) {
+        const qint64 ms = iThroughputTimer.elapsed();
+
+        // The last number stays on the screen once everything is out
+        if (frame.iComplete) {
+            DBG("The whole input has been sent");
+            iComplete = true;
+            if (ms > 0) {
+                Q_EMIT stream->throughputChanged(iBytes * 1000 / ms);
+            }
+        } else if (ms >= 1000) {
+            Q_EMIT stream->throughputChanged(iBytes * 1000 / ms);
+            iThroughputTimer.restart();
+            iBytes = 0;
+        }
+    }
+}
+
+//===========================================================================
+// QrClipStream
+//===========================================================================
+
+QrClipStream::QrClipStream(
+    const QString& aFileName,
+    int aFps,
+    QObject* aParent) :
+    QObject(aParent),
+    d(new Data((aFileName == QStringLiteral("-")) ?
+        static_cast<Source*>(new StdinSource) :
+        static_cast<Source*>(new FileSource(aFileName)),
+        qBound(1, aFps, MaxFps), this))
+{}
+
+bool
+QrClipStream::isValid() const
+{
+    return d->iValid;
+}
+
+#include "qrclip_stream.moc"
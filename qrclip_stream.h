@@ -0,0 +1,72 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_STREAM_H
+#define QRCLIP_STREAM_H
+
+#include "qrclip_symbol.h"
+
+#include <QtCore/QObject>
+
+// Streams a file (or stdin) as an endless sequence of QR codes. The data
+// are split into segments of up to MaxBlocks blocks, each frame carries
+// either a block or XOR of several randomly chosen blocks of the same
+// segment (LT code). Frames are encoded on a separate thread, which tries
+// to stay ahead of the display frame rate.
+class QrClipStream :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    QrClipStream(const QString&, int, QObject*);
+
+    bool isValid() const;
+
+Q_SIGNALS:
+    void frame(const QrClipSymbol&, const QString&);
+    void throughputChanged(qint64);
+
+private:
+    class Source;
+    class FileSource;
+    class StdinSource;
+    class Producer;
+    class Data;
+    Data* d;
+};
+
+#endif // QRCLIP_STREAM_H
@@ -0,0 +1,591 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_symbol.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_raster.h"
+#include "qrclip_segment.h"
+#include "qrclip_spec.h"
+#include "qrclip_stats.h"
+
+#include <QtCore/QBuffer>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QSharedData>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtGui/QPageSize>
+#include <QtGui/QPainter>
+#include <QtGui/QPainterPath>
+#include <QtGui/QPdfWriter>
+
+#include <math.h>
+
+//===========================================================================
+// QrClipSymbol::Data
+//===========================================================================
+
+class QrClipSymbol::Data :
+    public QSharedData
+{
+public:
+    Data(QRcode*);
+    Data(int, int, int, const QByteArray&);
+    ~Data();
+
+public:
+    QRcode* iCode;
+    const QByteArray iModules;
+    const int iVersion;
+    const int iWidth;
+    const int iHeight;
+    const uchar* iData;
+};
+
+QrClipSymbol::Data::Data(
+    QRcode* aCode) :
+    iCode(aCode),
+    iVersion(aCode->version),
+    iWidth(aCode->width),
+    iHeight(aCode->width),
+    iData(aCode->data)
+{}
+
+QrClipSymbol::Data::Data(
+    int aVersion,
+    int aWidth,
+    int aHeight,
+    const QByteArray& aModules) :
+    iCode(nullptr),
+    iModules(aModules),
+    iVersion(aVersion),
+    iWidth(aWidth),
+    iHeight(aHeight),
+    iData((const uchar*)iModules.constData())
+{}
+
+QrClipSymbol::Data::~Data()
+{
+    if (iCode) {
+        QRcode_free(iCode);
+    }
+}
+
+//===========================================================================
+// QrClipSymbol::StructuredTask
+//===========================================================================
+
+class QrClipSymbol::StructuredTask :
+    public QRunnable
+{
+public:
+    StructuredTask(QRinput*, QRcode**, QSemaphore*);
+
+    void run() override;
+
+private:
+    QRinput* iInput;
+    QRcode** iCode;
+    QSemaphore* iDone;
+};
+
+QrClipSymbol::StructuredTask::StructuredTask(
+    QRinput* aInput,
+    QRcode** aCode,
+    QSemaphore* aDone) :
+    iInput(aInput),
+    iCode(aCode),
+    iDone(aDone)
+{
+    setAutoDelete(true);
+}
+
+void
+QrClipSymbol::StructuredTask::run()
+{
+    *iCode = QRcode_encodeInput(iInput);
+    iDone->release();
+}
+
+//===========================================================================
+// QrClipSymbol
+//===========================================================================
+
+QrClipSymbol::QrClipSymbol()
+{}
+
+QrClipSymbol::QrClipSymbol(
+    Data* aData) :
+    d(aData)
+{}
+
+QrClipSymbol::QrClipSymbol(
+    const QrClipSymbol& aSymbol) :
+    d(aSymbol.d)
+{}
+
+QrClipSymbol::~QrClipSymbol()
+{}
+
+QrClipSymbol&
+QrClipSymbol::operator=(
+    const QrClipSymbol& aOther)
+{
+    d = aOther.d;
+    return *this;
+}
+
+// static
+QrClipSymbol
+QrClipSymbol::makeQrCode(
+    const QString& aText)
+{
+    return makeQrCode(aText, Params());
+}
+
+// static
+QrClipSymbol
+QrClipSymbol::makeQrCode(
+    const QString& aText,
+    const Params& aParams)
+{
+    QRCLIP_TIME(QrClipStageEncode);
+
+    if (aText.isEmpty()) {
+        return QrClipSymbol();
+    } else if (aParams.iMode == QR_MODE_NUL || aParams.iMicro) {
+        return makeQrCode(QrClipSegmenter(aText), aParams);
+    } else {
+        QRcode* code = QRcode_encodeString(aText.toUtf8().constData(),
+            aParams.iVersion, aParams.iLevel, aParams.iMode, true);
+
+        return code ? QrClipSymbol(new Data(code)) : QrClipSymbol();
+    }
+}
+
+// static
+QrClipSymbol
+QrClipSymbol::makeQrCode(
+    const QrClipSegmenter& aSegmenter,
+    const Params& aParams)
+{
+    if (!aSegmenter.isEmpty()) {
+        QRinput* input = nullptr;
+
+        if (aParams.iMicro) {
+            input = aSegmenter.makeMicroInput(aParams.iVersion,
+                aParams.iLevel);
+        } else {
+            const int version = aSegmenter.minVersion(aParams.iLevel);
+
+            // Zero version means that it doesn't fit at all
+            if (version) {
+                const int v = qMax(aParams.iVersion, version);
+
+                DBG("Version" << v << aSegmenter.bitCount(v) <<
+                    "bits, ECI" << QrClipSegmenter::eci(
+                    aSegmenter.charset(v)));
+                input = aSegmenter.makeInput(v, aParams.iLevel);
+            }
+        }
+
+        if (input) {
+            QRcode* code = QRcode_encodeInput(input);
+
+            QRinput_free(input);
+            if (code) {
+                return QrClipSymbol(new Data(code));
+            }
+        }
+    }
+    return QrClipSymbol();
+}
+
+// static
+QrClipSymbol
+QrClipSymbol::makeBinary(
+    const QByteArray& aData,
+    const Params& aParams)
+{
+    // Arbitrary bytes, including zeros, all in 8-bit mode
+    if (!aData.isEmpty()) {
+        QRcode* code = QRcode_encodeData(aData.size(),
+            (const uchar*)aData.constData(), aParams.iVersion,
+            aParams.iLevel);
+
+        if (code) {
+            return QrClipSymbol(new Data(code));
+        }
+    }
+    return QrClipSymbol();
+}
+
+// static
+QList<QrClipSymbol>
+QrClipSymbol::makeStructured(
+    const QByteArray& aUtf8,
+    QRecLevel aLevel,
+    int aMaxSymbols)
+{
+    QRCLIP_TIME(QrClipStageEncode);
+    const int total = aUtf8.size();
+    QList<QrClipSymbol> result;
+    QVector<int> chunks;
+
+    // Find the smallest version which fits the payload into aMaxSymbols.
+    // Chunks are split at UTF-8 character boundaries, so that each symbol
+    // makes sense on its own, even to readers unaware of structured append.
+    chunks.reserve(QrClipSpec::MaxStructuredAppendSymbols);
+    for (int v = QrClipSpec::MinVersion; v <= QrClipSpec::MaxVersion &&
+        result.isEmpty(); v++) {
+        const int capacity = QrClipSpec::byteCapacity(v, aLevel,
+            QrClipSpec::StructuredAppendBits);
+        int pos = 0;
+
+        chunks.resize(0);
+        while (pos < total && chunks.size() < aMaxSymbols) {
+            int end = qMin(pos + capacity, total);
+
+            while (end < total && end > pos && (aUtf8.at(end) & 0xc0) == 0x80) {
+                end--;
+            }
+            if (end == pos) {
+                // Not even one character fits
+                break;
+            }
+            chunks.append(end - pos);
+            pos = end;
+        }
+
+        if (pos == total && chunks.size() > 1) {
+            const int n = chunks.size();
+            QRinput_Struct* s = QRinput_Struct_new();
+            QVector<QRinput*> inputs(n);
+            bool ok = (s != nullptr);
+
+            DBG(n << "symbols, version" << v);
+            pos = 0;
+            for (int i = 0; i < n && ok; i++) {
+                QRinput* input = QRinput_new2(v, aLevel);
+
+                if (!input) {
+                    ok = false;
+                } else if (QRinput_append(input, QR_MODE_8, chunks.at(i),
+                    (const uchar*)aUtf8.constData() + pos) < 0 ||
+                    QRinput_Struct_appendInput(s, input) < 0) {
+                    QRinput_free(input);
+                    ok = false;
+                } else {
+                    inputs[i] = input;
+                    pos += chunks.at(i);
+                }
+            }
+
+            // This also calculates the parity. The inputs are still owned
+            // by QRinput_Struct, we only borrow them for parallel encoding.
+            if (ok && QRinput_Struct_insertStructuredAppendHeaders(s) == 0) {
+                QVector<QRcode*> codes(n);
+                QThreadPool* pool = QThreadPool::globalInstance();
+                QSemaphore done;
+
+                // Encode the symbols in parallel. If the pool has no
+                // free threads, the calling thread does the job itself.
+                for (int i = 0; i < n; i++) {
+                    StructuredTask* task = new StructuredTask(inputs.at(i),
+                        codes.data() + i, &done);
+
+                    if (!pool->tryStart(task)) {
+                        task->run();
+                        delete task;
+                    }
+                }
+                done.acquire(n);
+
+                for (int i = 0; i < n; i++) {
+                    if (codes.at(i)) {
+                        result.append(QrClipSymbol(new Data(codes.at(i))));
+                    } else {
+                        ok = false;
+                    }
+                }
+                if (!ok) {
+                    result.clear();
+                }
+            }
+
+            if (s) {
+                QRinput_Struct_free(s);
+            }
+            break;
+        } else if (pos == total) {
+            // The whole thing fits into a single symbol
+            break;
+        }
+    }
+    return result;
+}
+
+// static
+QrClipSymbol
+QrClipSymbol::tile(
+    const QList<QrClipSymbol>& aSymbols,
+    int aSpacing)
+{
+    const int n = aSymbols.size();
+
+    if (n == 1) {
+        return aSymbols.first();
+    } else if (n > 1) {
+        // All symbols in a structured append set have the same size
+        const int size = aSymbols.first().width();
+        const int cols = (int)ceil(sqrt((double)n));
+        const int rows = (n + cols - 1) / cols;
+        const int w = cols * size + (cols - 1) * aSpacing;
+        const int h = rows * size + (rows - 1) * aSpacing;
+        QByteArray modules(w * h, 0);
+        uchar* data = (uchar*)modules.data();
+
+        for (int i = 0; i < n; i++) {
+            const uchar* src = aSymbols.at(i).data();
+            uchar* dest = data + (i / cols) * (size + aSpacing) * w +
+                (i % cols) * (size + aSpacing);
+
+            for (int y = 0; y < size; y++) {
+                memcpy(dest + y * w, src + y * size, size);
+            }
+        }
+        return QrClipSymbol(new Data(aSymbols.first().version(), w, h,
+            modules));
+    }
+    return QrClipSymbol();
+}
+
+bool
+QrClipSymbol::isNull() const
+{
+    return !d || !d->iWidth;
+}
+
+int
+QrClipSymbol::version() const
+{
+    return d ? d->iVersion : 0;
+}
+
+int
+QrClipSymbol::width() const
+{
+    return d ? d->iWidth : 0;
+}
+
+int
+QrClipSymbol::height() const
+{
+    return d ? d->iHeight : 0;
+}
+
+const uchar*
+QrClipSymbol::data() const
+{
+    return d ? d->iData : nullptr;
+}
+
+int
+QrClipSymbol::byteCount() const
+{
+    // Approximate amount of memory occupied by the symbol
+    return d ? (sizeof(Data) + sizeof(QRcode) + width() * height()) : 0;
+}
+
+int
+QrClipSymbol::fitScale(
+    const QSize& aSize,
+    int aBorder) const
+{
+    return qMax(1, qMin(aSize.width() / (width() + 2 * aBorder),
+        aSize.height() / (height() + 2 * aBorder)));
+}
+
+QImage
+QrClipSymbol::makeImage(
+    int aScale,
+    int aBorder) const
+{
+    QRCLIP_TIME(QrClipStageRaster);
+    QrClipStats::count(QrClipStats::Renders);
+    const uchar* data = d->iData;
+    const uint size = d->iWidth;
+    const uint rows = d->iHeight;
+    const uint border = aScale * aBorder;
+    const uint imageRowSize = size * aScale + 2 * border;
+    const uint imageHeight = rows * aScale + 2 * border;
+
+    // Each pixel is a bit, an index into the colormap
+    QImage img(imageRowSize, imageHeight, QImage::Format_Mono);
+    img.setColorTable({0xffffffff, 0xff000000});
+    img.fill(0); // background, i.e. white
+
+    for (uint y = 0; y < rows; y++) {
+        const uint rowIndex = border + y * aScale;
+        uchar* imageRow = img.scanLine(rowIndex);
+
+        // Each uchar in QRcode represents a module (dot). If the
+        // less significant bit of the uchar is 1, the corresponding
+        // module is black. Each dot gets repeated aScale times.
+        QrClipRaster::expandRow(data + y * size, size, aScale, border,
+            imageRow);
+
+        // Repeat the entire row another (aScale - 1) times
+        for (int k = 1; k < aScale; k++) {
+            memcpy(img.scanLine(rowIndex + k), imageRow, img.bytesPerLine());
+        }
+    }
+    return img;
+}
+
+QVector<QRect>
+QrClipSymbol::moduleRects() const
+{
+    QVector<QRect> rects;
+
+    if (!isNull()) {
+        const uchar* data = d->iData;
+        const int size = d->iWidth;
+        const int rows = d->iHeight;
+
+        // Index of the rectangle ending at the previous row, for each
+        // column where a run starts, or -1
+        QVector<int> open(size, -1);
+        QVector<int> next(size, -1);
+
+        for (int y = 0; y < rows; y++) {
+            const uchar* row = data + y * size;
+            int x = 0;
+
+            while (x < size) {
+                if (row[x] & 1) {
+                    const int start = x;
+
+                    while (x < size && (row[x] & 1)) {
+                        x++;
+                    }
+
+                    const int i = open.at(start);
+
+                    if (i >= 0 && rects.at(i).width() == x - start) {
+                        rects[i].setBottom(y);
+                        next[start] = i;
+                    } else {
+                        next[start] = rects.size();
+                        rects.append(QRect(start, y, x - start, 1));
+                    }
+                } else {
+                    x++;
+                }
+            }
+            open.swap(next);
+            next.fill(-1);
+        }
+    }
+    return rects;
+}
+
+QPainterPath
+QrClipSymbol::makePath(
+    int aBorder) const
+{
+    const QVector<QRect> rects(moduleRects());
+    QPainterPath path;
+
+    for (int i = 0; i < rects.size(); i++) {
+        path.addRect(rects.at(i).translated(aBorder, aBorder));
+    }
+    return path;
+}
+
+QByteArray
+QrClipSymbol::makeSvg(
+    int aBorder) const
+{
+    const QVector<QRect> rects(moduleRects());
+    const QByteArray w(QByteArray::number(width() + 2 * aBorder));
+    const QByteArray h(QByteArray::number(height() + 2 * aBorder));
+    QByteArray svg;
+
+    // Each rectangle takes about 20 bytes
+    svg.reserve(256 + rects.size() * 20);
+    svg.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 ");
+    svg.append(w + ' ' + h + "\" shape-rendering=\"crispEdges\">\n"
+        "<rect width=\"" + w + "\" height=\"" + h + "\" fill=\"#fff\"/>\n"
+        "<path d=\"");
+    for (int i = 0; i < rects.size(); i++) {
+        const QRect& r = rects.at(i);
+        const QByteArray rw(QByteArray::number(r.width()));
+
+        svg.append('M' + QByteArray::number(r.x() + aBorder) + ',' +
+            QByteArray::number(r.y() + aBorder) + 'h' + rw + 'v' +
+            QByteArray::number(r.height()) + "h-" + rw + 'z');
+    }
+    svg.append("\"/>\n</svg>\n");
+    return svg;
+}
+
+QByteArray
+QrClipSymbol::makePdf(
+    int aBorder) const
+{
+    const int w = width() + 2 * aBorder;
+    const int h = height() + 2 * aBorder;
+    QByteArray pdf;
+    QBuffer buffer(&pdf);
+
+    if (!isNull() && buffer.open(QIODevice::WriteOnly)) {
+        QPdfWriter writer(&buffer);
+
+        // The page is exactly the size of the symbol
+        writer.setPageSize(QPageSize(QSizeF(w, h), QPageSize::Millimeter));
+        writer.setPageMargins(QMarginsF());
+
+        QPainter painter(&writer);
+
+        painter.setWindow(0, 0, w, h);
+        painter.fillPath(makePath(aBorder), Qt::black);
+        painter.end();
+    }
+    return pdf;
+}
@@ -0,0 +1,123 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#ifndef QRCLIP_SYMBOL_H
+#define QRCLIP_SYMBOL_H
+
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QList>
+#include <QtCore/QRect>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QImage>
+
+#include <qrencode.h>
+
+class QPainterPath;
+class QrClipSegmenter;
+
+// Immutable, implicitly shared QR code symbol. Safe to pass between
+// threads, which is what allows encoding it off the GUI thread. It can
+// also be a grid of symbols, in which case it's not necessarily square.
+class QrClipSymbol
+{
+public:
+    // Everything (other than the payload itself) affecting the output
+    // of the encoder. QR_MODE_NUL lets QrClipSegmenter pick the optimal
+    // mix of modes, anything else is a hint for libqrencode's own split.
+    // Micro QR symbols are always segmented by QrClipSegmenter.
+    class Params
+    {
+    public:
+        Params(int aVersion = 0, QRecLevel aLevel = QR_ECLEVEL_M,
+            QRencodeMode aMode = QR_MODE_NUL, bool aMicro = false) :
+            iVersion(aVersion), iLevel(aLevel), iMode(aMode),
+            iMicro(aMicro) {}
+
+        bool operator==(const Params& aParams) const
+            { return iVersion == aParams.iVersion &&
+                iLevel == aParams.iLevel && iMode == aParams.iMode &&
+                iMicro == aParams.iMicro; }
+        bool operator!=(const Params& aParams) const
+            { return !operator==(aParams); }
+
+    public:
+        int iVersion;
+        QRecLevel iLevel;
+        QRencodeMode iMode;
+        bool iMicro;
+    };
+
+    QrClipSymbol();
+    QrClipSymbol(const QrClipSymbol&);
+    QrClipSymbol& operator=(const QrClipSymbol&);
+    ~QrClipSymbol();
+
+    static QrClipSymbol makeQrCode(const QString&);
+    static QrClipSymbol makeQrCode(const QString&, const Params&);
+    static QrClipSymbol makeQrCode(const QrClipSegmenter&, const Params&);
+    static QrClipSymbol makeBinary(const QByteArray&, const Params&);
+    static QList<QrClipSymbol> makeStructured(const QByteArray&,
+        QRecLevel, int);
+    static QrClipSymbol tile(const QList<QrClipSymbol>&, int);
+
+    bool isNull() const;
+    int version() const;
+    int width() const;
+    int height() const;
+    const uchar* data() const;
+
+    int byteCount() const;
+    int fitScale(const QSize&, int) const;
+    QImage makeImage(int, int) const;
+
+    // Vector output, in module units. Dark modules are merged into
+    // horizontal runs, and identical runs in adjacent rows into a single
+    // rectangle. SVG and PDF have a single path, PDF has 1 mm modules.
+    QVector<QRect> moduleRects() const;
+    QPainterPath makePath(int) const;
+    QByteArray makeSvg(int) const;
+    QByteArray makePdf(int) const;
+
+private:
+    class Data;
+    class StructuredTask;
+    QrClipSymbol(Data*);
+    QExplicitlySharedDataPointer<Data> d;
+};
+
+#endif // QRCLIP_SYMBOL_H
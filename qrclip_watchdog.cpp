@@ -0,0 +1,222 @@
+// Copyright (C) 2025 Slava Monich <slava@monich.com>
+//
+// You may use this file under the terms of the BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  1. Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer
+//     in the documentation and/or other materials provided with the
+//     distribution.
+//
+//  3. Neither the names of the copyright holders nor the names of its
+//     contributors may be used to endorse or promote products derived
+//     from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The views and conclusions contained in the software and documentation
+// are those of the authors and should not be interpreted as representing
+// any official policies, either expressed or implied.
+
+#include "qrclip_watchdog.h"
+
+#include "qrclip_debug.h"
+#include "qrclip_stats.h"
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QWaitCondition>
+
+//===========================================================================
+// QrClipWatchdog::Thread
+//===========================================================================
+
+class QrClipWatchdog::Thread :
+    public QThread
+{
+public:
+    Thread(int, QObject*);
+
+    void beat();
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    static QString stageNames(uint);
+
+public:
+    const int iThreshold;
+    const int iInterval;
+
+private:
+    QElapsedTimer iClock;
+    QAtomicInteger<qint64> iLastBeat;
+    QMutex iMutex;
+    QWaitCondition iWakeUp;
+    bool iStop;
+};
+
+QrClipWatchdog::Thread::Thread(
+    int aThreshold,
+    QObject* aParent) :
+    QThread(aParent),
+    iThreshold(aThreshold),
+    iInterval(qMax(aThreshold / 4, 10)),
+    iStop(false)
+{
+    iClock.start();
+    iLastBeat.storeRelease(0);
+}
+
+// Called on the watched thread
+void
+QrClipWatchdog::Thread::beat()
+{
+    iLastBeat.storeRelease(iClock.elapsed());
+}
+
+void
+QrClipWatchdog::Thread::stop()
+{
+    iMutex.lock();
+    iStop = true;
+    iWakeUp.wakeAll();
+    iMutex.unlock();
+    wait();
+}
+
+// static
+QString
+QrClipWatchdog::Thread::stageNames(
+    uint aStages)
+{
+    QStringList names;
+
+    for (int i = 0; i < QrClipStageCount; i++) {
+        if (aStages & (1u << i)) {
+            names.append(QrClipStageTimer::name(QrClipStage(i)));
+        }
+    }
+    return names.isEmpty() ? QStringLiteral("no known stage") :
+        names.join(QStringLiteral(", "));
+}
+
+void
+QrClipWatchdog::Thread::run()
+{
+    qint64 stallBeat = -1;
+    uint stages = 0;
+
+    iMutex.lock();
+    while (!iStop) {
+        iWakeUp.wait(&iMutex, iInterval);
+        if (!iStop) {
+            const qint64 lastBeat = iLastBeat.loadAcquire();
+            const qint64 silence = iClock.elapsed() - lastBeat;
+
+            if (stallBeat < 0) {
+                if (silence > iThreshold) {
+                    // The stage is sampled on every tick while stalled
+                    const QrClipStage stage = QrClipStageTimer::activeStage();
+
+                    stallBeat = lastBeat;
+                    stages = (stage == QrClipStageNone) ? 0 : (1u << stage);
+                    QrClipStats::count(QrClipStats::Stalls);
+                    WARN("Event loop stalled for" << silence << "ms in" <<
+                        qPrintable(stageNames(stages)));
+                }
+            } else if (lastBeat != stallBeat) {
+                WARN("Event loop stall lasted" << (lastBeat - stallBeat) <<
+                    "ms in" << qPrintable(stageNames(stages)));
+                stallBeat = -1;
+            } else {
+                const QrClipStage stage = QrClipStageTimer::activeStage();
+
+                if (stage != QrClipStageNone) {
+                    stages |= (1u << stage);
+                }
+            }
+        }
+    }
+    iMutex.unlock();
+}
+
+//===========================================================================
+// QrClipWatchdog::Data
+//===========================================================================
+
+class QrClipWatchdog::Data :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Data(int, QrClipWatchdog*);
+    ~Data();
+
+private:
+    Thread* iThread;
+    QTimer* iHeartbeat;
+};
+
+QrClipWatchdog::Data::Data(
+    int aThreshold,
+    QrClipWatchdog* aParent) :
+    QObject(aParent),
+    iThread(new Thread(aThreshold, this)),
+    iHeartbeat(new QTimer(this))
+{
+    QrClipStageTimer::trackThisThread();
+
+    // The heartbeat is what the stalled event loop fails to deliver
+    iHeartbeat->setInterval(iThread->iInterval);
+    connect(iHeartbeat, &QTimer::timeout, iThread, &Thread::beat);
+    iThread->beat();
+    iHeartbeat->start();
+    iThread->start();
+    DBG("Watching for event loop stalls over" << aThreshold << "ms");
+}
+
+QrClipWatchdog::Data::~Data()
+{
+    iHeartbeat->stop();
+    iThread->stop();
+}
+
+//===========================================================================
+// QrClipWatchdog
+//===========================================================================
+
+QrClipWatchdog::QrClipWatchdog(
+    int aThresholdMs,
+    QObject* aParent) :
+    QObject(aParent),
+    d(new Data(aThresholdMs, this))
+{}
+
+QrClipWatchdog::~QrClipWatchdog()
+{}
+
+#include "qrclip_watchdog.moc"
@@ -36,18 +36,23 @@
 
 #include "qrclip_widget.h"
 
+#include "qrclip_clipboard.h"
 #include "qrclip_debug.h"
+#include "qrclip_encoder.h"
+#include "qrclip_spec.h"
+#include "qrclip_stats.h"
 
 #include <QtCore/QBuffer>
+#include <QtCore/QCache>
 #include <QtCore/QPointer>
-#include <QtGui/QClipboard>
-#include <QtGui/QGuiApplication>
+#include <QtCore/QTimer>
+#include <QtCore/QtMath>
 #include <QtGui/QIcon>
+#include <QtGui/QPainter>
+#include <QtGui/QPaintEvent>
 #include <QtGui/QPixmap>
 #include <QtWidgets/QStyle>
 
-#include <qrencode.h>
-
 //===========================================================================
 // QrClipWidget::Data
 //===========================================================================
@@ -61,80 +66,153 @@ public:
     class BlockImpl;
 
     Data(QLabel*);
-    ~Data();
 
-    void connectClipboard();
-    void disconnectClipboard();
-    QImage makeImage() const;
+    void start();
+    void encode();
+    qreal dpr() const;
+    QSize deviceSize() const;
+    QRect deviceRect(const QRect&) const;
+    int fitScale() const;
     QImage makeImage(int) const;
     bool haveQrCode() const;
+    QRect symbolRect(int) const;
+    void paintQrCode(QPainter*, const QRect&) const;
+    void setQrCodes(const QString&, const QList<QrClipSymbol>&, const QImage&);
+    void updateQrCodeWidget(QLabel*);
 
 private Q_SLOTS:
     void updateQrCode();
+    void updatePixmap();
+    void onResized();
+    void showNextSymbol();
+    void onEncoded(const QString&, const QList<QrClipSymbol>&, const QImage&);
 
 private:
-    static QString clipboardText();
-    static QRcode* makeQrCode(const QString&);
+    static QString toolTipText(const QString&);
+    const QString& appIconPngBase64();
     QrClipWidget* parentWidget() const;
-    void updateQrCodeWidget(QLabel*);
+    int pixmapKey(int) const;
+    QPixmap toPixmap(const QImage&) const;
+    QPixmap scaledPixmap(int);
+    void cachePixmap(int, const QPixmap&);
 
 public:
     const int iBorder;
-    const int iSaveScale;
     int iUpdatesBlocked;
+    bool iStarted;
+    bool iHaveText;
+    bool iEncoded;
+    bool iStreaming;
+    RenderMode iRenderMode;
+    QrClipClipboard* iClipboard;
+    QrClipEncoder* iEncoder;
+    QTimer* iResizeTimer;
+    QTimer* iCycleTimer;
+    QCache<int,QPixmap> iPixmapCache;
+    int iScale;
+    qreal iDpr;
     QString iAppIconPngBase64;
     QString iLastText;
-    QRcode* iCode;
+    QString iCodeText;
+    QList<QrClipSymbol> iCodes;
+    int iCurrent;
+    QrClipSymbol iCode;
 };
 
 QrClipWidget::Data::Data(
     QLabel* aLabel) :
     QObject(aLabel),
     iBorder(2),
-    iSaveScale(5),
     iUpdatesBlocked(0),
-    iLastText(clipboardText()),
-    iCode(makeQrCode(iLastText))
+    iStarted(false),
+    iHaveText(false),
+    iEncoded(false),
+    iStreaming(false),
+    iRenderMode(RenderPixmap),
+    iClipboard(new QrClipClipboard(this)),
+    iEncoder(new QrClipEncoder(iBorder, this)),
+    iResizeTimer(new QTimer(this)),
+    iCycleTimer(new QTimer(this)),
+    iPixmapCache(32 * 1024), // KiB
+    iScale(0),
+    iDpr(1),
+    iCurrent(0)
 {
-    QPixmap appIconPixmap(":/qrclip/app_icon");
-    QBuffer appIconBuffer;
-    appIconBuffer.open(QIODevice::WriteOnly);
-    appIconPixmap.save(&appIconBuffer, "png");
-    appIconBuffer.close();
-    iAppIconPngBase64 = QString::fromLatin1(appIconBuffer.data().toBase64());
-
-    connectClipboard();
-    updateQrCodeWidget(aLabel);
+    // Interactive resize generates lots of resize events, and only
+    // the last one within a display frame is worth reacting to.
+    iResizeTimer->setInterval(16);
+    iResizeTimer->setSingleShot(true);
+    connect(iResizeTimer, &QTimer::timeout, this, &Data::onResized);
+    connect(iCycleTimer, &QTimer::timeout, this, &Data::showNextSymbol);
+
+    // Nothing is fetched or encoded until the window has been painted
+    // for the first time (see start), unless that takes too long,
+    // e.g. because the window starts minimized. Plain text is cheap
+    // enough to show in the meantime.
+    connect(iEncoder, &QrClipEncoder::encoded, this, &Data::onEncoded);
+    connect(iClipboard, &QrClipClipboard::textChanged,
+        this, &Data::updateQrCode);
+    iClipboard->setPaused(true);
+    aLabel->setText(QString("Reading clipboard") + QChar(0x2026));
+    QTimer::singleShot(1000, this, &Data::start);
 }
 
-QrClipWidget::Data::~Data()
+void
+QrClipWidget::Data::start()
 {
-    QRcode_free(iCode);
+    if (!iStarted) {
+        DBG("Starting");
+        iStarted = true;
+
+        // Encoding starts when the clipboard text arrives
+        if (!iUpdatesBlocked && !iStreaming) {
+            iClipboard->setPaused(false);
+        }
+    }
 }
 
-// static
-QString
-QrClipWidget::Data::clipboardText()
+// Converting the icon takes time, and the placeholder may never be
+// needed at all
+const QString&
+QrClipWidget::Data::appIconPngBase64()
 {
-    QClipboard* clip = qGuiApp->clipboard();
-    QString text(clip->text(QClipboard::Selection));
-
-    return text.isEmpty() ? clip->text(QClipboard::Clipboard) : text;
+    if (iAppIconPngBase64.isEmpty()) {
+        QPixmap appIconPixmap(":/qrclip/app_icon");
+        QBuffer appIconBuffer;
+        appIconBuffer.open(QIODevice::WriteOnly);
+        appIconPixmap.save(&appIconBuffer, "png");
+        appIconBuffer.close();
+        iAppIconPngBase64 = QString::fromLatin1(appIconBuffer.data().
+            toBase64());
+    }
+    return iAppIconPngBase64;
 }
 
+// Tooltip can't show much anyway, and laying out megabytes of text for it
+// takes forever.
 // static
-QRcode*
-QrClipWidget::Data::makeQrCode(
+QString
+QrClipWidget::Data::toolTipText(
     const QString& aText)
 {
-    if (aText.isEmpty()) {
-        return nullptr;
-    } else {
-        const QByteArray utf8(aText.toUtf8());
-
-        return QRcode_encodeString(utf8.constData(), 0, QR_ECLEVEL_M,
-            QR_MODE_8, true);
+    const int maxChars = 256;
+    const int maxLines = 8;
+    QString text(aText.left(maxChars));
+    int pos = -1;
+
+    for (int i = 0; i < maxLines; i++) {
+        pos = text.indexOf('\n', pos + 1);
+        if (pos < 0) {
+            break;
+        }
+    }
+    if (pos >= 0) {
+        text.truncate(pos);
+    }
+    if (text.size() < aText.size()) {
+        text.append(QChar(0x2026)); // Horizontal ellipsis
     }
+    return text;
 }
 
 inline
@@ -148,120 +226,320 @@ inline
 bool
 QrClipWidget::Data::haveQrCode() const
 {
-    return iCode && iCode->width;
+    return !iCode.isNull();
 }
 
 void
-QrClipWidget::Data::connectClipboard()
+QrClipWidget::Data::encode()
 {
-    QClipboard* clip = QGuiApplication::clipboard();
-
-    if (clip) {
-        connect(clip, &QClipboard::dataChanged, this, &Data::updateQrCode);
-        connect(clip, &QClipboard::selectionChanged, this, &Data::updateQrCode);
+    // There's no need to rasterize the QR code when painting the
+    // modules directly. Until the clipboard has been read, there's
+    // nothing to encode.
+    if (iHaveText) {
+        iEncoder->encode(iLastText, deviceSize(),
+            iRenderMode == RenderPixmap);
     }
 }
 
-void
-QrClipWidget::Data::disconnectClipboard()
+inline
+qreal
+QrClipWidget::Data::dpr() const
 {
-    QClipboard* clip = QGuiApplication::clipboard();
+    return parentWidget()->devicePixelRatioF();
+}
 
-    if (clip) {
-        clip->disconnect(this);
-    }
+// Symbols are sized and rendered in device pixels, so that each module
+// takes a whole number of them, even if the DPR is fractional
+QSize
+QrClipWidget::Data::deviceSize() const
+{
+    const QSize size(parentWidget()->size());
+    const qreal ratio = dpr();
+
+    return QSize(qFloor(size.width() * ratio),
+        qFloor(size.height() * ratio));
 }
 
-QImage
-QrClipWidget::Data::makeImage() const
+// Smallest device pixel rectangle covering the logical one
+QRect
+QrClipWidget::Data::deviceRect(
+    const QRect& aRect) const
 {
-    const QLabel* l = parentWidget();
+    const qreal ratio = dpr();
 
-    return makeImage(qMax(1,
-            qMin(l->width(), l->height())/(iCode->width + 2 * iBorder)));
+    return QRect(QPoint(qFloor(aRect.left() * ratio),
+        qFloor(aRect.top() * ratio)), QPoint(
+        qCeil((aRect.right() + 1) * ratio) - 1,
+        qCeil((aRect.bottom() + 1) * ratio) - 1));
+}
+
+// Device pixels per module
+int
+QrClipWidget::Data::fitScale() const
+{
+    return iCode.fitScale(deviceSize(), iBorder);
 }
 
 QImage
 QrClipWidget::Data::makeImage(
     int aScale) const
 {
-    const uchar* data = iCode->data;
-    const uint size = iCode->width;
-    const uint border = aScale * iBorder;
-    const uint imageRowSize = size * aScale + 2 * border;
-
-    // Each pixel is an 8-bit index into the colormap
-    QImage img(imageRowSize, imageRowSize, QImage::Format_Indexed8);
-    img.setColorTable({0xffffffff, 0xff000000});
-    img.fill(0); // background, i.e. white
-
-    for (uint y = 0; y < size; y++) {
-        const uchar* src = data + y * size;
-        const uint rowIndex = border + y * aScale;
-        uchar* imageRow = img.scanLine(rowIndex);
-        uchar* dest = imageRow + border;
-
-        // Fill the line
-        for (uint x = 0; x < size; x++) {
-            // Each uchar in QRcode represents a module (dot). If the
-            // less significant bit of the uchar is 1, the corresponding
-            // module is black. The other bits are meaningless for usual
-            // applications.
-            const uchar dot = (*src++) & 1;
-
-            // Each dot gets repeated aScale times
-            for (uint k = 0; k < aScale; k++) {
-                *dest++ = dot;
-            }
-        }
+    return iCode.makeImage(aScale, iBorder);
+}
+
+inline
+int
+QrClipWidget::Data::pixmapKey(
+    int aScale) const
+{
+    // Structured append symbols are all of the same size
+    return aScale * QrClipSpec::MaxStructuredAppendSymbols + iCurrent;
+}
+
+QPixmap
+QrClipWidget::Data::scaledPixmap(
+    int aScale)
+{
+    const QPixmap* cached = iPixmapCache.object(pixmapKey(aScale));
+
+    if (cached) {
+        DBG("Using cached pixmap for scale" << aScale);
+        return *cached;
+    } else {
+        const QPixmap pixmap(toPixmap(makeImage(aScale)));
+
+        cachePixmap(aScale, pixmap);
+        return pixmap;
+    }
+}
+
+// The image is in device pixels, it's drawn without scaling
+QPixmap
+QrClipWidget::Data::toPixmap(
+    const QImage& aImage) const
+{
+    QRCLIP_TIME(QrClipStagePixmap);
+    QPixmap pixmap(QPixmap::fromImage(aImage));
+
+    pixmap.setDevicePixelRatio(iDpr);
+    return pixmap;
+}
+
+void
+QrClipWidget::Data::cachePixmap(
+    int aScale,
+    const QPixmap& aPixmap)
+{
+    iPixmapCache.insert(pixmapKey(aScale), new QPixmap(aPixmap),
+        aPixmap.width() * aPixmap.height() * aPixmap.depth() / 8192 + 1);
+}
+
+void
+QrClipWidget::Data::updatePixmap()
+{
+    if (haveQrCode() && iRenderMode == RenderPixmap) {
+        const int scale = fitScale();
 
-        // Repeat the entire row another (aScale - 1) times
-        for (uint k = 1; k < aScale; k++) {
-            memcpy(img.scanLine(rowIndex + k), imageRow, imageRowSize);
+        // Nothing to do if the scale hasn't changed
+        if (iScale != scale) {
+            iScale = scale;
+            parentWidget()->setPixmap(scaledPixmap(scale));
         }
     }
-    return img;
+}
+
+void
+QrClipWidget::Data::onResized()
+{
+    // A different size may call for a different symbol, in which case
+    // the current one is scaled while the new one is being encoded.
+    const qreal ratio = dpr();
+
+    // Moving to another screen may change the DPR, and that's the only
+    // reason to render the pixmaps again at the same widget size
+    if (iDpr != ratio) {
+        DBG("Device pixel ratio" << ratio);
+        iDpr = ratio;
+        iScale = 0;
+        iPixmapCache.clear();
+    }
+    if (!iStreaming) {
+        iEncoder->resize(deviceSize(), iRenderMode == RenderPixmap);
+    }
+    updatePixmap();
 }
 
 void
 QrClipWidget::Data::updateQrCode()
 {
-    QString text(clipboardText());
+    // QrClipClipboard only emits textChanged when it has changed
+    iLastText = iClipboard->text();
+    iHaveText = true;
+    DBG(iLastText.size() << "characters");
+
+    // The current QR code stays on the screen until the new one
+    // is ready.
+    encode();
+}
 
-    if (iLastText != text) {
-        QrClipWidget* widget = parentWidget();
-        const bool hadQrCode = haveQrCode();
+void
+QrClipWidget::Data::showNextSymbol()
+{
+    if (iCodes.size() > 1) {
+        iCurrent = (iCurrent + 1) % iCodes.size();
+        iCode = iCodes.at(iCurrent);
+        iScale = 0;
+        updateQrCodeWidget(parentWidget());
+    }
+}
 
-        DBG(text);
-        iLastText = text;
-        QRcode_free(iCode);
-        iCode = makeQrCode(iLastText);
-        updateQrCodeWidget(widget);
-        if (hadQrCode != haveQrCode()) {
-            Q_EMIT widget->haveQrCodeChanged(!hadQrCode);
-        }
+void
+QrClipWidget::Data::onEncoded(
+    const QString& aText,
+    const QList<QrClipSymbol>& aCodes,
+    const QImage& aImage)
+{
+    // Clipboard may still be encoded when streaming starts
+    if (!iStreaming) {
+        setQrCodes(aText, aCodes, aImage);
     }
 }
 
+void
+QrClipWidget::Data::setQrCodes(
+    const QString& aText,
+    const QList<QrClipSymbol>& aCodes,
+    const QImage& aImage)
+{
+    QrClipWidget* widget = parentWidget();
+    const bool hadQrCode = haveQrCode();
+
+    iEncoded = true;
+    iCodeText = aText;
+    iCodes = aCodes;
+    iCurrent = 0;
+    iCode = iCodes.isEmpty() ? QrClipSymbol() : iCodes.first();
+    iScale = 0;
+    iDpr = dpr();
+    iPixmapCache.clear();
+
+    // Structured append symbols which aren't tiled are shown one by one
+    if (iCodes.size() > 1 && iCycleTimer->interval() > 0) {
+        iCycleTimer->start();
+    } else {
+        iCycleTimer->stop();
+    }
+
+    // The widget may have been resized while the image was being
+    // rendered in the background, in which case it's useless.
+    if (iRenderMode == RenderPixmap && !aImage.isNull() &&
+        aImage.width() == (iCode.width() + 2 * iBorder) * fitScale()) {
+        cachePixmap(fitScale(), toPixmap(aImage));
+    }
+
+    updateQrCodeWidget(widget);
+
+    if (hadQrCode != haveQrCode()) {
+        Q_EMIT widget->haveQrCodeChanged(!hadQrCode);
+    }
+    Q_EMIT widget->qrCodeChanged();
+}
+
 void
 QrClipWidget::Data::updateQrCodeWidget(
     QLabel* aLabel)
 {
     if (haveQrCode()) {
-        aLabel->setToolTip(iLastText);
-        aLabel->setPixmap(QPixmap::fromImage(makeImage()));
-    } else {
+        aLabel->setToolTip((iCodes.size() > 1) ?
+            QString("[%1/%2] %3").arg(iCurrent + 1).arg(iCodes.size()).
+            arg(toolTipText(iCodeText)) : toolTipText(iCodeText));
+        if (iRenderMode == RenderPixmap) {
+            updatePixmap();
+        } else {
+            // This clears the text and schedules a repaint
+            aLabel->setPixmap(QPixmap());
+        }
+    } else if (iEncoded) {
+        // Until then, the initial placeholder stays
         aLabel->setToolTip(QString());
         aLabel->setPixmap(QPixmap());
         aLabel->setText(QString("<p align='center'>"
             "<img src='data:image/png;base64,%1'/></p>"
             "<p align='center'>%2</p>").
-            arg(iAppIconPngBase64, iLastText.isEmpty() ?
+            arg(appIconPngBase64(), iCodeText.isEmpty() ?
                 QStringLiteral("Clipboard is empty") :
                 QStringLiteral("Too much text for a QR code")));
     }
 }
 
+// In device pixels
+QRect
+QrClipWidget::Data::symbolRect(
+    int aScale) const
+{
+    // Same placement as QLabel would give to the pixmap
+    const QrClipWidget* widget = parentWidget();
+    const int m = widget->margin();
+    const QSize size((iCode.width() + 2 * iBorder) * aScale,
+        (iCode.height() + 2 * iBorder) * aScale);
+
+    return QStyle::alignedRect(widget->layoutDirection(), widget->alignment(),
+        size, deviceRect(widget->contentsRect().adjusted(m, m, -m, -m)));
+}
+
+void
+QrClipWidget::Data::paintQrCode(
+    QPainter* aPainter,
+    const QRect& aExposed) const
+{
+    const int scale = fitScale();
+    const QRect rect(symbolRect(scale));
+    const QRect exposed(deviceRect(aExposed) & rect);
+
+    if (!exposed.isEmpty()) {
+        const uchar* data = iCode.data();
+        const int size = iCode.width();
+        const int rows = iCode.height();
+        const int x0 = rect.left() + iBorder * scale;
+        const int y0 = rect.top() + iBorder * scale;
+
+        // Only the modules intersecting the exposed area
+        const int firstRow = qMax(0, (exposed.top() - y0) / scale);
+        const int lastRow = qMin(rows - 1, (exposed.bottom() - y0) / scale);
+        const int firstCol = qMax(0, (exposed.left() - x0) / scale);
+        const int lastCol = qMin(size - 1, (exposed.right() - x0) / scale);
+        QVector<QRect> runs;
+
+        for (int y = firstRow; y <= lastRow; y++) {
+            const uchar* row = data + y * size;
+
+            // Merge horizontally adjacent black modules into one rectangle
+            for (int x = firstCol; x <= lastCol; x++) {
+                if (row[x] & 1) {
+                    const int start = x;
+
+                    while (x < lastCol && (row[x + 1] & 1)) {
+                        x++;
+                    }
+                    runs.append(QRect(x0 + start * scale, y0 + y * scale,
+                        (x - start + 1) * scale, scale));
+                }
+            }
+        }
+
+        // Module edges fall on device pixel boundaries
+        const qreal ratio = dpr();
+
+        aPainter->save();
+        aPainter->scale(1 / ratio, 1 / ratio);
+        aPainter->fillRect(exposed, Qt::white);
+        aPainter->setPen(Qt::NoPen);
+        aPainter->setBrush(Qt::black);
+        aPainter->drawRects(runs);
+        aPainter->restore();
+    }
+}
+
 //===========================================================================
 // QrClipWidget::Data::BlockImpl
 //===========================================================================
@@ -280,7 +558,7 @@ QrClipWidget::Data::BlockImpl::BlockImpl(Data* aData) :
 {
     if (!aData->iUpdatesBlocked++) {
         DBG("Blocking QR code updates");
-        aData->disconnectClipboard();
+        aData->iClipboard->setPaused(true);
     }
 }
 
@@ -289,8 +567,9 @@ QrClipWidget::Data::BlockImpl::~BlockImpl()
     Data* d = iData;
     if (d && !--d->iUpdatesBlocked) {
         DBG("Resuming QR code updates");
-        d->connectClipboard();
-        d->updateQrCode();
+        if (!d->iStreaming && d->iStarted) {
+            d->iClipboard->setPaused(false);
+        }
     }
 }
 
@@ -313,10 +592,80 @@ QrClipWidget::haveQrCode() const
     return d->haveQrCode();
 }
 
-QImage
-QrClipWidget::image() const
+// The text shown as the QR code (or the placeholder, if it doesn't fit)
+QString
+QrClipWidget::qrCodeText() const
 {
-    return d->haveQrCode() ? d->makeImage(d->iSaveScale) : QImage();
+    return d->iCodeText;
+}
+
+// The symbol currently shown (one of them, if there are several)
+QrClipSymbol
+QrClipWidget::qrCode() const
+{
+    return d->iCode;
+}
+
+// Quiet zone, in modules
+int
+QrClipWidget::border() const
+{
+    return d->iBorder;
+}
+
+void
+QrClipWidget::setStructuredAppend(
+    bool aEnabled,
+    int aCycleInterval)
+{
+    // Zero interval means that the symbols are tiled
+    d->iEncoder->setStructuredAppend(aEnabled ?
+        int(QrClipSpec::MaxStructuredAppendSymbols) : 1,
+        aCycleInterval <= 0);
+    d->iCycleTimer->setInterval(qMax(aCycleInterval, 0));
+    d->encode();
+}
+
+void
+QrClipWidget::setPolicy(
+    int aModulePixels,
+    bool aMicro)
+{
+    // Zero aModulePixels means fixed error correction level M
+    d->iEncoder->setPolicy(aModulePixels, aMicro);
+    d->encode();
+}
+
+void
+QrClipWidget::showFrame(
+    const QrClipSymbol& aCode,
+    const QString& aLabel)
+{
+    if (!d->iStreaming) {
+        DBG("Streaming, not following the clipboard anymore");
+        d->iClipboard->setPaused(true);
+        d->iStreaming = true;
+    }
+    d->setQrCodes(aLabel, QList<QrClipSymbol>() << aCode, QImage());
+}
+
+QrClipWidget::RenderMode
+QrClipWidget::renderMode() const
+{
+    return d->iRenderMode;
+}
+
+void
+QrClipWidget::setRenderMode(
+    RenderMode aMode)
+{
+    if (d->iRenderMode != aMode) {
+        DBG("Render mode" << aMode);
+        d->iRenderMode = aMode;
+        d->iScale = 0;
+        d->iPixmapCache.clear();
+        d->updateQrCodeWidget(this);
+    }
 }
 
 QrClipWidget::Blocker
@@ -329,9 +678,9 @@ QSize
 QrClipWidget::minimumSizeHint() const
 {
     if (d->haveQrCode()) {
-        const int size = d->iCode->width + 2 * (d->iBorder + margin());
+        const int border = 2 * (d->iBorder + margin());
 
-        return QSize(size, size);
+        return QSize(d->iCode.width() + border, d->iCode.height() + border);
     } else {
         return QLabel::minimumSizeHint();
     }
@@ -341,10 +690,51 @@ void
 QrClipWidget::resizeEvent(
     QResizeEvent* aEvent)
 {
-    if (d->haveQrCode()) {
-        setPixmap(QPixmap::fromImage(d->makeImage()));
+    if (d->haveQrCode() && !d->iResizeTimer->isActive()) {
+        d->iResizeTimer->start();
     }
     QLabel::resizeEvent(aEvent);
 }
 
+bool
+QrClipWidget::event(
+    QEvent* aEvent)
+{
+    switch (aEvent->type()) {
+    case QEvent::ScreenChangeInternal:
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    case QEvent::DevicePixelRatioChange:
+#endif
+        // The DPR may have changed, onResized() checks that
+        if (d->haveQrCode()) {
+            d->iResizeTimer->start();
+        }
+        break;
+    default:
+        break;
+    }
+    return QLabel::event(aEvent);
+}
+
+void
+QrClipWidget::paintEvent(
+    QPaintEvent* aEvent)
+{
+    QRCLIP_TIME(QrClipStagePaint);
+    QrClipStats::count(QrClipStats::Paints);
+
+    // The first frame is out, time to get to work
+    if (!d->iStarted) {
+        QTimer::singleShot(0, d, &Data::start);
+    }
+
+    if (d->haveQrCode() && d->iRenderMode == RenderDirect) {
+        QPainter painter(this);
+
+        d->paintQrCode(&painter, aEvent->rect());
+    } else {
+        QLabel::paintEvent(aEvent);
+    }
+}
+
 #include "qrclip_widget.moc"
@@ -39,30 +39,46 @@
 
 #include <QtCore/QExplicitlySharedDataPointer>
 #include <QtCore/QSharedData>
-#include <QtGui/QImage>
 #include <QtWidgets/QLabel>
 
+class QrClipSymbol;
+
 class QrClipWidget :
     public QLabel
 {
     Q_OBJECT
 
 public:
+    enum RenderMode {
+        RenderPixmap,   // QLabel showing a pre-rendered pixmap
+        RenderDirect    // Modules painted by paintEvent
+    };
+
     struct Block : public QSharedData { virtual ~Block() = default; };
     typedef QExplicitlySharedDataPointer<Block> Blocker;
 
     QrClipWidget(QWidget*);
 
     bool haveQrCode() const;
-    QImage image() const;
+    QString qrCodeText() const;
+    QrClipSymbol qrCode() const;
+    int border() const;
+    RenderMode renderMode() const;
+    void setRenderMode(RenderMode);
+    void setStructuredAppend(bool, int);
+    void setPolicy(int, bool);
+    void showFrame(const QrClipSymbol&, const QString&);
     Blocker blockUpdates();
 
 Q_SIGNALS:
     void haveQrCodeChanged(bool);
+    void qrCodeChanged();
 
 protected:
     QSize minimumSizeHint() const override;
+    bool event(QEvent*) override;
     void resizeEvent(QResizeEvent*) override;
+    void paintEvent(QPaintEvent*) override;
 
 private:
     class Data;
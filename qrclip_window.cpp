@@ -38,13 +38,19 @@
 
 #include "qrclip_debug.h"
 #include "qrclip_config.h"
+#include "qrclip_export.h"
+#include "qrclip_mimedata.h"
+#include "qrclip_stream.h"
 #include "qrclip_widget.h"
 
+#include <QtCore/QFileInfo>
+#include <QtCore/QTimer>
 #include <QtGui/QClipboard>
 #include <QtGui/QGuiApplication>
 #include <QtGui/QIcon>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QStatusBar>
 
 //===========================================================================
 // QrClipWindow::Data
@@ -56,35 +62,135 @@ class QrClipWindow::Data :
     Q_OBJECT
 
 public:
-    Data(const QrClipConfig&, QrClipWindow*);
+    Data(const QrClipConfig&, QrClipStream*, QrClipWidget*, QrClipExport*,
+        QrClipWindow*);
 
     QrClipWindow* parentWindow() const;
     QByteArray windowGeometry() const;
-    void saveWindowGeometry(QByteArray);
+    void scheduleGeometrySave();
+    void flushGeometry();
     bool alwaysOnTop() const;
 
 public Q_SLOTS:
+    void saveWindowGeometry();
     void onCopyTriggered();
     void onSaveTriggered();
     void onAlwaysOnTopToggled(bool);
+    void onThroughputChanged(qint64);
+    void onSaved(const QString&);
+    void onSaveFailed(const QString&, const QString&);
 
 public:
     QrClipConfig iConfig;
     const QString iGeometryKey;
     const QString iAlwaysOnTopKey;
+    const QString iDirectRenderingKey;
+    const QString iStructuredAppendKey;
+    const QString iCycleIntervalKey;
+    const QString iModulePixelsKey;
+    const QString iMicroQrKey;
+    const QString iSaveScaleKey;
+    const QString iPngCompressionKey;
     QrClipWidget* iClipWidget;
+    QrClipExport* iExport;
+    int iSaveScale;
+    QTimer* iGeometryTimer;
 };
 
 QrClipWindow::Data::Data(
     const QrClipConfig& aConfig,
+    QrClipStream* aStream,
+    QrClipWidget* aClipWidget,
+    QrClipExport* aExport,
     QrClipWindow* aParent) :
     QObject(aParent),
     iConfig(aConfig),
     iGeometryKey("geometry"),
     iAlwaysOnTopKey("alwaysOnTop"),
-    iClipWidget(new QrClipWidget(aParent))
+    iDirectRenderingKey("directRendering"),
+    iStructuredAppendKey("structuredAppend"),
+    iCycleIntervalKey("cycleInterval"),
+    iModulePixelsKey("modulePixels"),
+    iMicroQrKey("microQr"),
+    iSaveScaleKey("saveScale"),
+    iPngCompressionKey("pngCompression"),
+    iClipWidget(aClipWidget ? aClipWidget : new QrClipWidget(aParent)),
+    iExport(aExport ? aExport : new QrClipExport(this)),
+    iSaveScale(5),
+    iGeometryTimer(new QTimer(this))
 {
-    // Set up the actions
+    // Moving or resizing the window generates lots of events. Geometry
+    // is only saved when they stop coming.
+    iGeometryTimer->setSingleShot(true);
+    iGeometryTimer->setInterval(250);
+    connect(iGeometryTimer, &QTimer::timeout,
+        this, &Data::saveWindowGeometry);
+
+    // A widget inherited from the previous window keeps its state,
+    // including the symbol and the rendered pixmap. That's the whole
+    // point of passing it over.
+    if (!aClipWidget) {
+        // Painting modules directly is cheaper but off by default
+        if (iConfig.get(iDirectRenderingKey).toBool()) {
+            iClipWidget->setRenderMode(QrClipWidget::RenderDirect);
+        }
+
+        // Text too long for a single QR code may be split into several
+        // symbols, tiled or shown one after another every cycleInterval
+        // milliseconds
+        if (iConfig.get(iStructuredAppendKey).toBool()) {
+            iClipWidget->setStructuredAppend(true,
+                iConfig.get(iCycleIntervalKey).toInt());
+        }
+
+        // Symbol size and error correction level are chosen to keep at
+        // least modulePixels pixels per module (4 by default, 0 turns that
+        // off). Micro QR is off by default because few phones can read it.
+        const QVariant modulePixels(iConfig.get(iModulePixelsKey));
+        iClipWidget->setPolicy(modulePixels.isValid() ?
+            modulePixels.toInt() : 4, iConfig.get(iMicroQrKey).toBool());
+    }
+
+    // Destroying QrClipExport waits for the saves in progress. The one
+    // inherited from the previous window lets that window go right away,
+    // and the saves it has started get reported by this one.
+    if (aExport) {
+        aExport->disconnect();
+        aExport->setParent(this);
+    }
+
+    // Saved and copied images have saveScale pixels per module (5 by
+    // default), PNG files are compressed at zlib level pngCompression
+    // (9 by default)
+    const QVariant saveScale(iConfig.get(iSaveScaleKey));
+    const QVariant pngCompression(iConfig.get(iPngCompressionKey));
+    if (saveScale.isValid()) {
+        iSaveScale = qMax(saveScale.toInt(), 1);
+    }
+    iExport->setPngOptions(iSaveScale, pngCompression.isValid() ?
+        pngCompression.toInt() : 9);
+    connect(iExport, &QrClipExport::saved, this, &Data::onSaved);
+    connect(iExport, &QrClipExport::failed, this, &Data::onSaveFailed);
+
+    // Stream frames replace the clipboard contents
+    if (aStream) {
+        if (!aClipWidget) {
+            connect(aStream, &QrClipStream::frame,
+                iClipWidget, &QrClipWidget::showFrame);
+        }
+        connect(aStream, &QrClipStream::throughputChanged,
+            this, &Data::onThroughputChanged);
+    }
+
+    // Set up the actions, replacing those of the previous window
+    if (aClipWidget) {
+        const QList<QAction*> actions(iClipWidget->actions());
+
+        for (int i = 0; i < actions.size(); i++) {
+            iClipWidget->removeAction(actions.at(i));
+        }
+    }
+
     QAction* copy = new QAction(QIcon::fromTheme("edit-copy"), "Copy", this);
     copy->setShortcut(QKeySequence::Copy);
     copy->setShortcutContext(Qt::WindowShortcut);
@@ -128,10 +234,26 @@ QrClipWindow::Data::windowGeometry() const
 }
 
 void
-QrClipWindow::Data::saveWindowGeometry(
-    QByteArray aGeometry)
+QrClipWindow::Data::saveWindowGeometry()
+{
+    iGeometryTimer->stop();
+    iConfig.set(iGeometryKey, QString::fromLatin1(parentWindow()->
+        saveGeometry().toHex()));
+}
+
+inline
+void
+QrClipWindow::Data::scheduleGeometrySave()
+{
+    iGeometryTimer->start();
+}
+
+void
+QrClipWindow::Data::flushGeometry()
 {
-    iConfig.set(iGeometryKey, QString::fromLatin1(aGeometry.toHex()));
+    if (iGeometryTimer->isActive()) {
+        saveWindowGeometry();
+    }
 }
 
 bool
@@ -144,35 +266,73 @@ QrClipWindow::Data::alwaysOnTop() const
 void
 QrClipWindow::Data::onCopyTriggered()
 {
-    QImage image(iClipWidget->image());
-
-    if (!image.isNull()) {
-        DBG("Copying the image into the clipboard");
-        QGuiApplication::clipboard()->setImage(image);
+    if (iClipWidget->haveQrCode()) {
+        // Formats are rendered on demand
+        DBG("Copying the QR code into the clipboard");
+        QGuiApplication::clipboard()->setMimeData(new QrClipMimeData(
+            iClipWidget->qrCode(), iClipWidget->border(), iSaveScale,
+            iClipWidget->qrCodeText()));
     }
 }
 
 void
 QrClipWindow::Data::onSaveTriggered()
 {
-    QImage image(iClipWidget->image());
-
-    if (!image.isNull()) {
-        DBG("Saving the image");
+    if (iClipWidget->haveQrCode()) {
+        DBG("Saving the QR code");
 
         QrClipWidget::Blocker block(iClipWidget->blockUpdates());
-        QString name = QFileDialog::getSaveFileName(parentWindow(),
-            QStringLiteral("Save QR code image"),
-            QStringLiteral("qrcode.png"),
-            QStringLiteral("Image (*.png)"));
+        const QString png(QStringLiteral("PNG image (*.png)"));
+        const QString svg(QStringLiteral("SVG image (*.svg)"));
+        const QString pdf(QStringLiteral("PDF document (*.pdf)"));
+        QString filter(png);
+        QString name;
+
+        {
+            QRCLIP_TIME(QrClipStageFileDialog);
+            name = QFileDialog::getSaveFileName(parentWindow(),
+                QStringLiteral("Save QR code"),
+                QStringLiteral("qrcode.png"),
+                png + ";;" + svg + ";;" + pdf, &filter);
+        }
 
         if (!name.isEmpty()) {
-            DBG("Writing" << qPrintable(name));
-            image.save(name);
+            // The file name suffix wins, the filter is used if there's
+            // no (known) suffix
+            QString suffix(QFileInfo(name).suffix().toLower());
+
+            if (suffix != "png" && suffix != "svg" && suffix != "pdf") {
+                suffix = (filter == svg) ? "svg" : (filter == pdf) ?
+                    "pdf" : "png";
+                name += '.' + suffix;
+            }
+
+            // The window isn't blocked while the file is being written
+            iExport->save(iClipWidget->qrCode(), iClipWidget->border(),
+                name, (suffix == "svg") ? QrClipExport::Svg :
+                (suffix == "pdf") ? QrClipExport::Pdf : QrClipExport::Png);
         }
     }
 }
 
+void
+QrClipWindow::Data::onSaved(
+    const QString& aFile)
+{
+    parentWindow()->statusBar()->showMessage(QString("Saved %1").
+        arg(aFile), 5000);
+}
+
+void
+QrClipWindow::Data::onSaveFailed(
+    const QString& aFile,
+    const QString& aError)
+{
+    WARN("Failed to save" << qPrintable(aFile) << qPrintable(aError));
+    parentWindow()->statusBar()->showMessage(QString("Failed to save "
+        "%1: %2").arg(aFile, aError));
+}
+
 void
 QrClipWindow::Data::onAlwaysOnTopToggled(
     bool aAlwaysOnTop)
@@ -183,6 +343,7 @@ QrClipWindow::Data::onAlwaysOnTopToggled(
     // Disassociate window from the data to stop the window from modifying
     // the config.
     QrClipWindow* window = parentWindow();
+    flushGeometry();
     window->d = nullptr;
 
     // Setting Qt::WindowStaysOnTopHint here (which hides the window) and
@@ -191,16 +352,31 @@ QrClipWindow::Data::onAlwaysOnTopToggled(
     Q_EMIT window->restart();
 }
 
+void
+QrClipWindow::Data::onThroughputChanged(
+    qint64 aBytesPerSec)
+{
+    parentWindow()->statusBar()->showMessage(QString("%1 bytes/s").
+        arg(aBytesPerSec));
+}
+
 //===========================================================================
 // QrClipWindow
 //===========================================================================
 
 QrClipWindow::QrClipWindow(
-    const QrClipConfig& aConfig) :
+    const QrClipConfig& aConfig,
+    QrClipStream* aStream,
+    QrClipWindow* aPrevious) :
     d(nullptr)
 {
-    // Not assign it yet
-    Data* data = new Data(aConfig, this);
+    // Not assign it yet. The previous window (if any) gives up its
+    // widget, there's no reason to encode and render everything again,
+    // and its exporter, which may be still saving something.
+    Data* data = new Data(aConfig, aStream, aPrevious ?
+        qobject_cast<QrClipWidget*>(aPrevious->takeCentralWidget()) :
+        nullptr, aPrevious ? aPrevious->findChild<QrClipExport*>() :
+        nullptr, this);
 
     // First set up the window
     setCentralWidget(data->iClipWidget);
@@ -225,7 +401,7 @@ QrClipWindow::moveEvent(
     QMainWindow::moveEvent(aEvent);
     if (d) {
         DBG("Window position" << qPrintable(QString("(%1,%2)").arg(x()).arg(y())));
-        d->saveWindowGeometry(saveGeometry());
+        d->scheduleGeometrySave();
     }
 }
 
@@ -236,7 +412,7 @@ QrClipWindow::resizeEvent(
     QMainWindow::resizeEvent(aEvent);
     if (d) {
         DBG("Window size" << qPrintable(QString("%1x%2").arg(width()).arg(height())));
-        d->saveWindowGeometry(saveGeometry());
+        d->scheduleGeometrySave();
     }
 }
 
@@ -245,6 +421,9 @@ QrClipWindow::closeEvent(
     QCloseEvent* aEvent)
 {
     QMainWindow::closeEvent(aEvent);
+    if (d) {
+        d->flushGeometry();
+    }
     Q_EMIT closed();
 }
 
@@ -40,6 +40,7 @@
 #include <QtWidgets/QMainWindow>
 
 class QrClipConfig;
+class QrClipStream;
 
 class QrClipWindow :
     public QMainWindow
@@ -47,7 +48,8 @@ class QrClipWindow :
     Q_OBJECT
 
 public:
-    QrClipWindow(const QrClipConfig&);
+    QrClipWindow(const QrClipConfig&, QrClipStream* aStream = nullptr,
+        QrClipWindow* aPrevious = nullptr);
 
 Q_SIGNALS:
     void restart();